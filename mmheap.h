@@ -44,7 +44,14 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 /**
  * The `_mmheap` namespace contains functions that are only intended for internal
@@ -67,7 +74,7 @@ namespace _mmheap{
      * @param  i value to compute the log_2 for (must be > 0)
      * @return log-base-2 of `i`
      */
-    uint64_t log_2(uint64_t i) {
+    inline uint64_t log_2(uint64_t i) {
         static const uint64_t tab64[64] = {
             63,  0, 58,  1, 59, 47, 53,  2,
             60, 39, 48, 27, 54, 33, 42,  3,
@@ -104,15 +111,15 @@ namespace _mmheap{
      * @param   heap_array  the heap
      * @param   i           the index (parent) for which to find the min-child
      * @param   right-index the index of the right-most element that is part of the heap
-     * @tparam  DataType    the type of data stored in the heap - must be
-     *                      LessThanComparable, Swappable, CopyConstructable,
-     *                      and CopyAssignable
+     * @tparam  HeapArray   a pointer to the heap's values, or any cheaply copied
+     *                      accessor whose `operator[](size_t)` returns a reference
+     *                      to them (see `mmheap_storage.h`)
      * @return  a pair where the first element is `true` if `i` has children (`false`
      *          otherwise), and the second element is the index of the child whose value
      *          is smallest (only if the first element is `true`)
      */
-    template <typename DataType>
-    std::pair<bool, size_t> min_child(const DataType* heap_array, size_t i, size_t right_index){
+    template <typename HeapArray>
+    std::pair<bool, size_t> min_child(HeapArray heap_array, size_t i, size_t right_index){
         std::pair<bool, size_t> result{false, 0};
         if(left(i) <= right_index){
             auto m = left(i);
@@ -131,15 +138,15 @@ namespace _mmheap{
      * @param   heap_array  the heap
      * @param   i           the index (parent) for which to find the min-grandchild
      * @param   right-index the index of the right-most element that is part of the heap
-     * @tparam  DataType    the type of data stored in the heap - must be
-     *                      LessThanComparable, Swappable, CopyConstructable,
-     *                      and CopyAssignable
+     * @tparam  HeapArray   a pointer to the heap's values, or any cheaply copied
+     *                      accessor whose `operator[](size_t)` returns a reference
+     *                      to them (see `mmheap_storage.h`)
      * @return  a pair where the first element is `true` if `i` has grandchildren
      *          (`false` otherwise), and the second element is the index of the
      *          grandchild whose value is smallest (only if the first element is `true`)
      */
-    template <typename DataType>
-    std::pair<bool, size_t> min_gchild(const DataType* heap_array, size_t i, size_t right_index){
+    template <typename HeapArray>
+    std::pair<bool, size_t> min_gchild(HeapArray heap_array, size_t i, size_t right_index){
         std::pair<bool, size_t> result{false, 0};
         auto l = left(i);
         auto r = right(i);
@@ -166,16 +173,16 @@ namespace _mmheap{
      * @param   heap_array  the heap
      * @param   i           the index (parent) for which to find the min-(grand)child
      * @param   right-index the index of the right-most element that is part of the heap
-     * @tparam  DataType    the type of data stored in the heap - must be
-     *                      LessThanComparable, Swappable, CopyConstructable,
-     *                      and CopyAssignable
+     * @tparam  HeapArray   a pointer to the heap's values, or any cheaply copied
+     *                      accessor whose `operator[](size_t)` returns a reference
+     *                      to them (see `mmheap_storage.h`)
      * @return  a pair where the first element is `true` if `i` has children
      *          (`false` otherwise), and the second element is the index of the
      *          child or grandchild whose value is smallest (only if the first
      *          element is `true`)
      */
-    template <typename DataType>
-    std::pair<bool, size_t> min_child_or_gchild(const DataType* heap_array, size_t i, size_t right_index){
+    template <typename HeapArray>
+    std::pair<bool, size_t> min_child_or_gchild(HeapArray heap_array, size_t i, size_t right_index){
         auto m = min_child(heap_array, i, right_index);
         if(m.first){
             auto  gm = min_gchild(heap_array, i, right_index);
@@ -191,15 +198,15 @@ namespace _mmheap{
      * @param   heap_array  the heap
      * @param   i           the index (parent) for which to find the max-child
      * @param   right-index the index of the right-most element that is part of the heap
-     * @tparam  DataType    the type of data stored in the heap - must be
-     *                      LessThanComparable, Swappable, CopyConstructable,
-     *                      and CopyAssignable
+     * @tparam  HeapArray   a pointer to the heap's values, or any cheaply copied
+     *                      accessor whose `operator[](size_t)` returns a reference
+     *                      to them (see `mmheap_storage.h`)
      * @return  a pair where the first element is `true` if `i` has children (`false`
      *          otherwise), and the second element is the index of the child whose value
      *          is largest (only if the first element is `true`)
      */
-    template <typename DataType>
-    std::pair<bool, size_t> max_child(const DataType* heap_array, size_t i, size_t right_index){
+    template <typename HeapArray>
+    std::pair<bool, size_t> max_child(HeapArray heap_array, size_t i, size_t right_index){
         std::pair<bool, size_t> result {false, 0};
         if(left(i) <= right_index){
             auto m = left(i);
@@ -218,15 +225,15 @@ namespace _mmheap{
      * @param   heap_array  the heap
      * @param   i           the index (parent) for which to find the max-grandchild
      * @param   right-index the index of the right-most element that is part of the heap
-     * @tparam  DataType    the type of data stored in the heap - must be
-     *                      LessThanComparable, Swappable, CopyConstructable,
-     *                      and CopyAssignable
+     * @tparam  HeapArray   a pointer to the heap's values, or any cheaply copied
+     *                      accessor whose `operator[](size_t)` returns a reference
+     *                      to them (see `mmheap_storage.h`)
      * @return  a pair where the first element is `true` if `i` has grandchildren
      *          (`false` otherwise), and the second element is the index of the
      *          grandchild whose value is largest (only if the first element is `true`)
      */
-    template <typename DataType>
-    std::pair<bool, size_t> max_gchild(const DataType* heap_array, size_t i, size_t right_index){
+    template <typename HeapArray>
+    std::pair<bool, size_t> max_gchild(HeapArray heap_array, size_t i, size_t right_index){
         std::pair<bool, size_t> result{false, 0};
         auto l = left(i);
         auto r = right(i);
@@ -253,16 +260,16 @@ namespace _mmheap{
      * @param   heap_array  the heap
      * @param   i           the index (parent) for which to find the max-(grand)child
      * @param   right-index the index of the right-most element that is part of the heap
-     * @tparam  DataType    the type of data stored in the heap - must be
-     *                      LessThanComparable, Swappable, CopyConstructable,
-     *                      and CopyAssignable
+     * @tparam  HeapArray   a pointer to the heap's values, or any cheaply copied
+     *                      accessor whose `operator[](size_t)` returns a reference
+     *                      to them (see `mmheap_storage.h`)
      * @return  a pair where the first element is `true` if `i` has children
      *          (`false` otherwise), and the second element is the index of the
      *          child or grandchild whose value is largest (only if the first
      *          element is `true`)
      */
-    template <typename DataType>
-    std::pair<bool, size_t> max_child_or_gchild(const DataType* heap_array, size_t i, size_t right_index){
+    template <typename HeapArray>
+    std::pair<bool, size_t> max_child_or_gchild(HeapArray heap_array, size_t i, size_t right_index){
         auto m = max_child(heap_array, i, right_index);
         if(m.first){
             auto gm  = max_gchild(heap_array, i, right_index);
@@ -277,13 +284,16 @@ namespace _mmheap{
      * @param heap_array  the heap
      * @param sift_index  the index of the element that should be sifted down
      * @param right_index the index of the right-most element that is part of the heap
-     * @tparam  DataType    the type of data stored in the heap - must be
-     *                      LessThanComparable, Swappable, CopyConstructable,
-     *                      and CopyAssignable
+     * @tparam  HeapArray   a pointer to the heap's values, or any cheaply copied
+     *                      accessor whose `operator[](size_t)` returns a reference
+     *                      to them (see `mmheap_storage.h`)
+     * @return `true` if the value at `sift_index` was moved (`false` if it
+     *         was already in place)
      */
-    template <typename DataType>
-    void sift_down_min(DataType* heap_array, size_t sift_index, size_t right_index){
+    template <typename HeapArray>
+    bool sift_down_min(HeapArray heap_array, size_t sift_index, size_t right_index){
         bool sift_more = true;
+        bool moved     = false;
         while(sift_more && left(sift_index) <= right_index){                            // if a[i] has children
             sift_more = false;
             auto mp = min_child_or_gchild(heap_array, sift_index, right_index);         // get min child or grandchild
@@ -291,11 +301,13 @@ namespace _mmheap{
             if(child(sift_index, m)){                                                   // if the min was a child
                 if(heap_array[m] < heap_array[sift_index]){
                     std::swap(heap_array[m], heap_array[sift_index]);
+                    moved = true;
                 }
             }
             else{                                                                       // min was a grandchild
                 if(heap_array[m] < heap_array[sift_index]){
                     std::swap(heap_array[m], heap_array[sift_index]);
+                    moved = true;
                     if(heap_array[parent(m)] < heap_array[m]){
                         std::swap(heap_array[m], heap_array[parent(m)]);
                     }
@@ -304,6 +316,7 @@ namespace _mmheap{
                 }
             }
         }
+        return moved;
     }
 
     /**
@@ -312,13 +325,16 @@ namespace _mmheap{
      * @param heap_array  the heap
      * @param sift_index  the index of the element that should be sifted down
      * @param right_index the index of the right-most element that is part of the heap
-     * @tparam  DataType    the type of data stored in the heap - must be
-     *                      LessThanComparable, Swappable, CopyConstructable,
-     *                      and CopyAssignable
+     * @tparam  HeapArray   a pointer to the heap's values, or any cheaply copied
+     *                      accessor whose `operator[](size_t)` returns a reference
+     *                      to them (see `mmheap_storage.h`)
+     * @return `true` if the value at `sift_index` was moved (`false` if it
+     *         was already in place)
      */
-    template <typename DataType>
-    void sift_down_max(DataType* heap_array, size_t sift_index, size_t right_index){
+    template <typename HeapArray>
+    bool sift_down_max(HeapArray heap_array, size_t sift_index, size_t right_index){
         bool sift_more = true;
+        bool moved     = false;
         while(sift_more && left(sift_index) <= right_index){                            // if a[i] has children
             sift_more = false;
             auto mp = max_child_or_gchild(heap_array, sift_index, right_index);         // get max child or grandchild
@@ -326,11 +342,13 @@ namespace _mmheap{
             if(child(sift_index, m)){                                                   // if the max was a child
                 if(heap_array[sift_index] < heap_array[m]){
                     std::swap(heap_array[m], heap_array[sift_index]);
+                    moved = true;
                 }
             }
             else{                                                                       // max was a grandchild
                 if(heap_array[sift_index] < heap_array[m]){
                     std::swap(heap_array[m], heap_array[sift_index]);
+                    moved = true;
                     if(heap_array[m] < heap_array[parent(m)]){
                         std::swap(heap_array[m], heap_array[parent(m)]);
                     }
@@ -339,6 +357,7 @@ namespace _mmheap{
                 }
             }
         }
+        return moved;
     }
 
     /**
@@ -347,17 +366,19 @@ namespace _mmheap{
      * @param heap_array  the heap
      * @param sift_index  the index of the element that should be sifted down
      * @param right_index the index of the right-most element that is part of the heap
-     * @tparam  DataType    the type of data stored in the heap - must be
-     *                      LessThanComparable, Swappable, CopyConstructable,
-     *                      and CopyAssignable
+     * @tparam  HeapArray   a pointer to the heap's values, or any cheaply copied
+     *                      accessor whose `operator[](size_t)` returns a reference
+     *                      to them (see `mmheap_storage.h`)
+     * @return `true` if the value at `sift_index` was moved (`false` if it
+     *         was already in place)
      */
-    template <typename DataType>
-    void sift_down(DataType* heap_array, size_t sift_index, size_t right_index){
+    template <typename HeapArray>
+    bool sift_down(HeapArray heap_array, size_t sift_index, size_t right_index){
         if(min_level(sift_index)){
-            sift_down_min(heap_array, sift_index, right_index);
+            return sift_down_min(heap_array, sift_index, right_index);
         }
         else{
-            sift_down_max(heap_array, sift_index, right_index);
+            return sift_down_max(heap_array, sift_index, right_index);
         }
     }
 
@@ -366,12 +387,12 @@ namespace _mmheap{
      *
      * @param heap_array    the heap
      * @param bubble_index  the index of the element that should be bubbled up
-     * @tparam  DataType    the type of data stored in the heap - must be
-     *                      LessThanComparable, Swappable, CopyConstructable,
-     *                      and CopyAssignable
+     * @tparam  HeapArray   a pointer to the heap's values, or any cheaply copied
+     *                      accessor whose `operator[](size_t)` returns a reference
+     *                      to them (see `mmheap_storage.h`)
      */
-    template <typename DataType>
-    void bubble_up_min(DataType* heap_array, size_t bubble_index){
+    template <typename HeapArray>
+    void bubble_up_min(HeapArray heap_array, size_t bubble_index){
         bool finished = false;
         while(!finished && has_gparent(bubble_index)){
             finished = true;
@@ -388,12 +409,12 @@ namespace _mmheap{
      *
      * @param heap_array    the heap
      * @param bubble_index  the index of the element that should be bubbled up
-     * @tparam  DataType    the type of data stored in the heap - must be
-     *                      LessThanComparable, Swappable, CopyConstructable,
-     *                      and CopyAssignable
+     * @tparam  HeapArray   a pointer to the heap's values, or any cheaply copied
+     *                      accessor whose `operator[](size_t)` returns a reference
+     *                      to them (see `mmheap_storage.h`)
      */
-    template <typename DataType>
-    void bubble_up_max(DataType* heap_array, size_t bubble_index){
+    template <typename HeapArray>
+    void bubble_up_max(HeapArray heap_array, size_t bubble_index){
         bool finished = false;
         while(!finished && has_gparent(bubble_index)){
             finished = true;
@@ -410,12 +431,12 @@ namespace _mmheap{
      *
      * @param heap_array    the heap
      * @param bubble_index  the index of the element that should be bubbled up
-     * @tparam  DataType    the type of data stored in the heap - must be
-     *                      LessThanComparable, Swappable, CopyConstructable,
-     *                      and CopyAssignable
+     * @tparam  HeapArray   a pointer to the heap's values, or any cheaply copied
+     *                      accessor whose `operator[](size_t)` returns a reference
+     *                      to them (see `mmheap_storage.h`)
      */
-    template <typename DataType>
-    void bubble_up(DataType* heap_array, size_t bubble_index){
+    template <typename HeapArray>
+    void bubble_up(HeapArray heap_array, size_t bubble_index){
         if(min_level(bubble_index)){
             if(has_parent(bubble_index) && heap_array[parent(bubble_index)] < heap_array[bubble_index]){
                 std::swap(heap_array[bubble_index], heap_array[parent(bubble_index)]);
@@ -435,6 +456,638 @@ namespace _mmheap{
             }
         }
     }
+
+    /**
+     * restore the heap property after the value at `index` was overwritten
+     *
+     * @param heap_array  the heap
+     * @param index       the index whose value changed
+     * @param old_value   the value that was at `index` before
+     * @param right_index the index of the right-most element that is part of the heap
+     * @tparam  HeapArray   a pointer to the heap's values, or any cheaply copied
+     *                      accessor whose `operator[](size_t)` returns a reference
+     *                      to them (see `mmheap_storage.h`)
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      and CopyAssignable
+     */
+    template <typename HeapArray, typename DataType>
+    void repair_at(HeapArray heap_array, size_t index, const DataType& old_value, size_t right_index){
+        const DataType& new_value = heap_array[index];
+        if(min_level(index)){
+            if(new_value < old_value){
+                bubble_up_min(heap_array, index);
+            }
+            else{
+                if(has_parent(index) && heap_array[parent(index)] < new_value){
+                    bubble_up(heap_array, index);
+                }
+                sift_down(heap_array, index, right_index);
+            }
+        }
+        else{
+            if(old_value < new_value){
+                bubble_up_max(heap_array, index);
+            }
+            else{
+                if(has_parent(index) && new_value < heap_array[parent(index)]){
+                    bubble_up(heap_array, index);
+                }
+                sift_down(heap_array, index, right_index);
+            }
+        }
+    }
+
+    /**
+     * @brief   restore the heap property after the values in a range of indices changed
+     * @details Re-sifts every index in `[first, last]` and then every ancestor of
+     *          those indices, bottom-up, exactly once.  This is Floyd's algorithm
+     *          restricted to the paths that lead to the changed range: it is correct
+     *          because every subtree that doesn't contain a changed index was already
+     *          a valid min-max (or max-min) heap.  The cost is proportional to the
+     *          size of the range plus the number of distinct ancestors, rather than
+     *          to one full-height repair per changed value.
+     *
+     * @param heap_array  the heap
+     * @param first       the first changed index
+     * @param last        the last changed index (must be >= `first`)
+     * @param right_index the index of the right-most element that is part of the heap
+     * @tparam  HeapArray   a pointer to the heap's values, or any cheaply copied
+     *                      accessor whose `operator[](size_t)` returns a reference
+     *                      to them (see `mmheap_storage.h`)
+     */
+    template <typename HeapArray>
+    void repair_range(HeapArray heap_array, size_t first, size_t last, size_t right_index){
+        if(left(first) > right_index && first > 0){                                     // leaves have nothing to sift; start at their parents
+            last  = parent(last);
+            first = parent(first);
+        }
+        bool finished = false;
+        while(!finished){
+            for(size_t current = last; ; --current){                                    // children are always re-sifted before parents
+                sift_down(heap_array, current, right_index);
+                if(current == first){
+                    break;
+                }
+            }
+            finished = first == 0;
+            if(!finished){
+                last  = std::min(parent(last), first - 1);                              // ancestors already re-sifted above need no second pass
+                first = parent(first);
+            }
+        }
+    }
+
+    /**
+     * @brief   sort a list of heap indices and remove duplicates
+     * @details Small lists are sorted with `std::sort()`; larger ones are marked in
+     *          a bitmap of the heap and read back in order, which is linear in the
+     *          size of the heap / 64 plus the number of indices instead of
+     *          O(k log k).
+     *
+     * @param indices     the indices (each must be < `count`)
+     * @param index_count the number of entries in `indices`
+     * @param count       the number of values in the heap
+     * @return the distinct indices in ascending order
+     */
+    inline std::vector<size_t> sort_indices(const size_t* indices, size_t index_count, size_t count){
+        std::vector<size_t> sorted;
+        if(index_count < count / 256){
+            sorted.assign(indices, indices + index_count);
+            std::sort(sorted.begin(), sorted.end());
+            sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+        }
+        else{
+            std::vector<uint64_t> marks((count + 63) / 64, 0);
+            for(size_t i = 0; i < index_count; ++i){
+                marks[indices[i] / 64] |= uint64_t(1) << (indices[i] % 64);
+            }
+            sorted.reserve(index_count);
+            for(size_t w = 0; w < marks.size(); ++w){
+                for(auto bits = marks[w]; bits != 0; bits &= bits - 1){
+                    sorted.push_back(w * 64 + log_2(bits & (~bits + 1)));                 // lowest set bit first
+                }
+            }
+        }
+        return sorted;
+    }
+
+    /**
+     * @brief   restore the heap property after the values at arbitrary indices changed
+     * @details The scattered-index counterpart of `repair_range()`.  The min-max
+     *          ordering is local - each value is only compared against its children
+     *          and grandchildren - so a changed value can only break the ordering at
+     *          its own index, its parent, or its grandparent.  Indices are processed
+     *          bottom-up (children always before their parents): each changed index
+     *          is sifted down, and once its value is final it is compared against its
+     *          parent and grandparent; an ancestor is queued for its own sift only if
+     *          that comparison shows it is out of order.  A change that is already in
+     *          place therefore costs a sift and two comparisons instead of a walk to
+     *          the root.  Parents and grandparents are generated in descending order
+     *          as the indices are processed in descending order, so they are kept in
+     *          two FIFOs and merged with `dirty` without any further sorting.
+     *
+     * @param heap_array  the heap
+     * @param dirty       the changed indices, sorted in descending order (duplicates allowed)
+     * @param dirty_count the number of indices in `dirty`
+     * @param right_index the index of the right-most element that is part of the heap
+     * @tparam  HeapArray   a pointer to the heap's values, or any cheaply copied
+     *                      accessor whose `operator[](size_t)` returns a reference
+     *                      to them (see `mmheap_storage.h`)
+     */
+    template <typename HeapArray>
+    void repair_indices(HeapArray heap_array, const size_t* dirty, size_t dirty_count, size_t right_index){
+        std::vector<size_t> parents;                                                    // FIFOs of indices still to re-sift, each in descending order
+        std::vector<size_t> gparents;
+        size_t next_parent  = 0;
+        size_t next_gparent = 0;
+        size_t d            = 0;
+        auto queue = [](std::vector<size_t>& fifo, size_t i){
+            if(fifo.empty() || fifo.back() != i){
+                fifo.push_back(i);
+            }
+        };
+        auto check_up = [&](size_t i){                                                  // queue the parent and grandparent if `i` is out of order with them
+            if(i > 0){
+                auto min = min_level(i);                                                // the parent is on the other kind of level, the grandparent on the same
+                auto p   = parent(i);
+                if(min ? heap_array[p] < heap_array[i] : heap_array[i] < heap_array[p]){
+                    queue(parents, p);
+                }
+                if(p > 0){
+                    auto gp = parent(p);
+                    if(min ? heap_array[i] < heap_array[gp] : heap_array[gp] < heap_array[i]){
+                        queue(gparents, gp);
+                    }
+                }
+            }
+        };
+        while(d < dirty_count || next_parent < parents.size() || next_gparent < gparents.size()){
+            size_t current = 0;                                                         // the largest index at the head of any stream
+            if(d < dirty_count){
+                current = dirty[d];
+            }
+            if(next_parent < parents.size()){
+                current = std::max(current, parents[next_parent]);
+            }
+            if(next_gparent < gparents.size()){
+                current = std::max(current, gparents[next_gparent]);
+            }
+            bool changed = false;                                                       // whether the value at `current` is new
+            while(d < dirty_count && dirty[d] == current){
+                changed = true;
+                ++d;
+            }
+            while(next_parent < parents.size() && parents[next_parent] == current){
+                ++next_parent;
+            }
+            while(next_gparent < gparents.size() && gparents[next_gparent] == current){
+                ++next_gparent;
+            }
+            if(changed){
+                check_up(current);                                                      // a new value sifted into a child still sits below the grandparent
+            }
+            if(sift_down(heap_array, current, right_index)){
+                check_up(current);
+            }
+        }
+    }
+
+    /**
+     * @brief   remove the values at a set of indices and repair the heap once
+     * @details Victims at or beyond the new end of the heap are simply dropped;
+     *          every other victim's slot is filled with a surviving value from the
+     *          tail.  Since the victims are sorted, the filled slots are exactly the
+     *          victims below the new count, and only those are repaired (see
+     *          `repair_indices()`) - unless `repair` is cleared because the caller
+     *          rebuilds the whole heap afterwards.
+     *
+     * @param         heap_array   the heap
+     * @param[in,out] count        the number of values in the heap (will update)
+     * @param         victims      the indices to remove, sorted ascending with no duplicates
+     * @param         victim_count the number of indices in `victims`
+     * @param         removed      if not null, receives the removed values (in index order)
+     * @param         repair       `false` to leave the filled slots unrepaired
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      and CopyAssignable
+     */
+    template <typename DataType>
+    void remove_sorted_indices(DataType* heap_array, size_t& count, const size_t* victims, size_t victim_count,
+                               DataType* removed, bool repair){
+        if(removed){
+            for(size_t v = 0; v < victim_count; ++v){
+                removed[v] = heap_array[victims[v]];
+            }
+        }
+        auto   new_count = count - victim_count;
+        size_t holes     = std::lower_bound(victims, victims + victim_count, new_count) - victims;
+        size_t tail      = victim_count;                                                // victims[holes, tail) are dropped with the tail
+        size_t donor     = count;
+        for(size_t h = 0; h < holes; ++h){
+            --donor;
+            while(tail > holes && victims[tail-1] == donor){                            // skip victims to reach the next surviving value from the end
+                --tail;
+                --donor;
+            }
+            heap_array[victims[h]] = heap_array[donor];
+        }
+        count = new_count;
+        if(repair && holes > 0){
+            std::vector<size_t> dirty(victims, victims + holes);
+            std::reverse(dirty.begin(), dirty.end());
+            repair_indices(heap_array, dirty.data(), dirty.size(), count-1);
+        }
+    }
+
+    /**
+     * @brief   rearrange a sorted array into a min-max heap without comparisons
+     * @details Level `d` of the heap is the index range `[2^d - 1, 2^(d+1) - 1)`.
+     *          Filling the min-levels, top down, with the smallest remaining values
+     *          and the max-levels with the largest gives a valid heap: every value
+     *          on a min-level is below every value deeper than it, and every value
+     *          on a max-level is above every value deeper than it.  In an ascending
+     *          array the min-level blocks are already in level order at the front,
+     *          and the max-level blocks are in reverse level order at the back (and
+     *          the other way around in a descending array).
+     *
+     *          One `std::reverse()` of the back part puts its blocks in level order,
+     *          and the blocks are then interleaved from the deepest level up: each
+     *          block of the front part is rotated past the blocks of the back part
+     *          that belong above it.  The rotations shrink geometrically, so the
+     *          whole rearrangement moves O(n) values.
+     *
+     * @param heap_array  the sorted array (will become a heap)
+     * @param size        the number of values in the array
+     * @param descending  `true` if the array is sorted in descending order
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      Swappable, MoveConstructible, and MoveAssignable
+     */
+    template <typename DataType>
+    void sorted_layout_in_place(DataType* heap_array, size_t size, bool descending){
+        if(size < 2){
+            return;
+        }
+        auto   deepest  = log_2(size);                                                  // the level of index `size-1`
+        size_t low_size = 0;
+        for(uint64_t d = 0; d <= deepest; d += 2){
+            low_size += std::min(size_t(1) << d, size - ((size_t(1) << d) - 1));
+        }
+        size_t front_end = descending ? size - low_size : low_size;                     // front blocks are in [0, front_end)
+        size_t back_end  = size;                                                        // back blocks are in [front_end, back_end)
+        std::reverse(heap_array + front_end, heap_array + size);
+        for(auto d = deepest; d > 0; --d){
+            auto first = (size_t(1) << d) - 1;
+            auto width = std::min(size_t(1) << d, size - first);
+            if((d % 2 == 0) != descending){                                             // level `d` is in the front part
+                std::rotate(heap_array + front_end - width, heap_array + front_end, heap_array + back_end);
+                front_end -= width;
+            }
+            back_end -= width;
+        }
+    }
+
+    /**
+     * @brief   lay out a sorted subsequence of an array as a heap, and insert the rest
+     * @details Scans the array once, compacting a "spine" of values that are in
+     *          order (ascending, or descending) to the front and setting the others
+     *          aside.  A value that is out of order with the end of the spine is
+     *          normally set aside itself, but if up to `max_backtrack` values at the
+     *          end of the spine are all above it and so are the values that follow
+     *          it, those spine values are the outliers and are set aside instead.
+     *          The spine is then laid out with `sorted_layout_in_place()` and the
+     *          set-aside values are appended and repaired with `repair_range()`.
+     *
+     *          If more than `max_aside` values have to be set aside, the array is
+     *          restored to a permutation of its original values and `false` is
+     *          returned without building the heap.
+     *
+     * @param heap_array  the array (will become a heap if successful)
+     * @param size        the number of values in the array
+     * @param descending  `true` to look for a descending spine
+     * @param max_aside   the maximum number of values that may be set aside
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, MoveConstructible,
+     *                      and MoveAssignable
+     * @return `true` if the heap was built
+     */
+    template <typename DataType>
+    bool sorted_spine_layout(DataType* heap_array, size_t size, bool descending, size_t max_aside){
+        const size_t max_backtrack = 4;
+        auto before = [descending](const DataType& a, const DataType& b){ return descending ? b < a : a < b; };
+        std::vector<DataType> aside;
+        size_t kept = 0;                                                                // the spine is heap_array[0, kept)
+        for(size_t i = 0; i < size; ++i){
+            if(kept == 0 || !before(heap_array[i], heap_array[kept-1])){
+                if(kept != i){
+                    heap_array[kept] = std::move(heap_array[i]);
+                }
+                ++kept;
+                continue;
+            }
+            auto j = kept;                                                              // the spine values above heap_array[i] start at j
+            while(j > 0 && kept - j < max_backtrack && before(heap_array[i], heap_array[j-1])){
+                --j;
+            }
+            bool outliers = (j == 0 || !before(heap_array[i], heap_array[j-1])) && i + (kept - j) < size;
+            for(auto k = i + 1; outliers && k <= i + (kept - j); ++k){
+                outliers = before(heap_array[k], heap_array[j]) && (j == 0 || !before(heap_array[k], heap_array[j-1]));
+            }
+            if(outliers){
+                std::move(heap_array + j, heap_array + kept, std::back_inserter(aside));
+                kept = j;
+                heap_array[kept++] = std::move(heap_array[i]);
+            }
+            else{
+                aside.push_back(std::move(heap_array[i]));
+            }
+            if(aside.size() > max_aside){
+                std::move(aside.begin(), aside.end(), heap_array + kept);               // refill the gap [kept, i]
+                return false;
+            }
+        }
+        sorted_layout_in_place(heap_array, kept, descending);
+        if(!aside.empty()){
+            std::move(aside.begin(), aside.end(), heap_array + kept);
+            repair_range(heap_array, kept, size-1, size-1);
+        }
+        return true;
+    }
+
+    /**
+     * @brief   build a heap from presorted input without Floyd's algorithm, if the
+     *          input is ordered enough
+     * @details A pre-scan measures the disorder of the array and picks a builder.
+     *          It first samples `sample_size` adjacent pairs spread evenly over the
+     *          array, counting rises, falls, and changes of direction.
+     *            * If the sample changes direction at most once, the natural runs
+     *              (maximal ascending or descending stretches) are counted, stopping
+     *              as soon as there are more than two.  A sorted array is a single
+     *              run, laid out directly by `sorted_layout_in_place()`.  An
+     *              organ-pipe array is two runs, which are merged with
+     *              `std::inplace_merge()` and then laid out.  More runs are left to
+     *              Floyd's algorithm, which is already cheap on long runs and beats
+     *              merging them.
+     *            * Otherwise the falls (or the rises, for descending input) in the
+     *              sample estimate how many values are out of place.  If they are
+     *              rare, the input is treated as sorted with noise and
+     *              `sorted_spine_layout()` builds the heap, giving up once more than
+     *              1/16 of the values are out of place.
+     *          Random input fails both tests after the sample alone.
+     *
+     * @param heap_array  the array (will become a heap if successful)
+     * @param size        the number of values in the array
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, MoveConstructible,
+     *                      and MoveAssignable
+     * @return `true` if the heap was built; `false` if the input should be given
+     *         to Floyd's algorithm (the array then holds a permutation of its values)
+     */
+    template <typename DataType>
+    bool build_presorted(DataType* heap_array, size_t size){
+        const size_t max_runs    = 2;
+        const size_t sample_size = 1024;                                                // adjacent pairs sampled for inversions
+        if(size < 3){
+            return false;
+        }
+        size_t rises   = 0;
+        size_t falls   = 0;
+        size_t turns   = 0;                                                             // changes of direction between sampled pairs
+        int    last_up = -1;
+        auto   pairs   = std::min(size - 1, sample_size);
+        for(size_t p = 0; p < pairs; ++p){
+            auto i = p * (size - 1) / pairs;                                            // adjacent pairs spread evenly over the array
+            if(heap_array[i] < heap_array[i+1] || heap_array[i+1] < heap_array[i]){
+                int up = heap_array[i] < heap_array[i+1];
+                rises += up;
+                falls += !up;
+                turns += last_up >= 0 && up != last_up;
+                last_up = up;
+            }
+        }
+        if(turns < max_runs){
+            std::vector<size_t> ends;                                                   // one past the end of each run
+            std::vector<bool>   falling;                                                // whether each run is descending
+            for(size_t first = 0; first < size && ends.size() <= max_runs; ){
+                auto last = first + 1;
+                bool down = last < size && heap_array[last] < heap_array[first];
+                while(last < size && (down ? !(heap_array[last-1] < heap_array[last]) : !(heap_array[last] < heap_array[last-1]))){
+                    ++last;
+                }
+                ends.push_back(last);
+                falling.push_back(down);
+                first = last;
+            }
+            if(ends.size() == 1){
+                sorted_layout_in_place(heap_array, size, falling[0]);
+                return true;
+            }
+            if(ends.size() == 2){
+                auto middle = ends[0];
+                if(falling[0]){
+                    std::reverse(heap_array, heap_array + middle);
+                }
+                if(falling[1]){
+                    std::reverse(heap_array + middle, heap_array + size);
+                }
+                std::inplace_merge(heap_array, heap_array + middle, heap_array + size);
+                sorted_layout_in_place(heap_array, size, false);
+                return true;
+            }
+        }
+        if(std::min(rises, falls) * 16 > pairs){
+            return false;
+        }
+        return sorted_spine_layout(heap_array, size, falls > rises, size / 16);
+    }
+
+    /**
+     * @brief   the key of an integer for radix sorting: its bits as an unsigned
+     *          integer, with the sign bit flipped for signed types so that the keys
+     *          sort in the same order as the values
+     */
+    template <typename DataType>
+    typename std::make_unsigned<DataType>::type radix_key(DataType value){
+        typedef typename std::make_unsigned<DataType>::type Key;
+        return std::is_signed<DataType>::value ? Key(Key(value) ^ Key(Key(1) << (8 * sizeof(Key) - 1))) : Key(value);
+    }
+
+    /**
+     * @brief   the number of bytes a radix sort must examine to sort some integers
+     * @details Only the range of the keys matters, since the sort works on each
+     *          key's offset from the smallest key.  The scan stops early once the
+     *          range needs more than `limit` bytes.
+     *
+     * @param      values  the integers
+     * @param      size    the number of integers
+     * @param      limit   the largest number of bytes of interest to the caller
+     * @param[out] low     receives the smallest key (see `radix_key()`), if the
+     *                     result is no more than `limit`
+     * @tparam  DataType    an integral type
+     * @return the number of bytes in the largest offset from `low`, or `limit + 1`
+     *         if that is more than `limit`
+     */
+    template <typename DataType>
+    size_t radix_bytes(const DataType* values, size_t size, size_t limit, typename std::make_unsigned<DataType>::type& low){
+        typedef typename std::make_unsigned<DataType>::type Key;
+        const size_t block = 256;                                                       // values scanned between checks of the range
+        auto bytes_of = [](uint64_t range){
+            size_t bytes = 0;
+            for(; range > 0; range >>= 8){
+                ++bytes;
+            }
+            return bytes;
+        };
+        low       = Key(~Key(0));
+        Key high  = 0;
+        for(size_t first = 0; first < size; first += block){
+            auto last = std::min(size, first + block);
+            for(auto i = first; i < last; ++i){
+                auto k = radix_key(values[i]);
+                low  = std::min(low, k);
+                high = std::max(high, k);
+            }
+            if(bytes_of(high - low) > limit){
+                return limit + 1;
+            }
+        }
+        return size > 0 ? bytes_of(high - low) : 0;
+    }
+
+    /**
+     * @brief   LSD radix sort of integers, one byte per pass
+     * @details Sorts on each key's offset from the smallest key (see
+     *          `radix_bytes()`), so keys that span a narrow range take few passes
+     *          however wide their type is.  One read pass builds the histograms of
+     *          all `bytes` bytes, and each byte is then scattered in a stable pass,
+     *          ping-ponging between `values` and `buffer`.
+     *
+     * @param values  the integers to sort (also used as scratch space)
+     * @param buffer  scratch space for `size` integers
+     * @param size    the number of integers
+     * @param low     the smallest key, from `radix_bytes()`
+     * @param bytes   the number of bytes to sort on, from `radix_bytes()`
+     * @tparam  DataType    an integral type
+     * @return the array (`values` or `buffer`) that holds the sorted integers
+     */
+    template <typename DataType>
+    DataType* radix_sort(DataType* values, DataType* buffer, size_t size,
+                         typename std::make_unsigned<DataType>::type low, size_t bytes){
+        std::vector<size_t> counts(256 * bytes, 0);
+        for(size_t i = 0; i < size; ++i){
+            uint64_t offset = radix_key(values[i]) - low;
+            for(size_t b = 0; b < bytes; ++b){
+                ++counts[256 * b + ((offset >> (8 * b)) & 0xff)];
+            }
+        }
+        auto from = values;
+        auto to   = buffer;
+        for(size_t b = 0; b < bytes; ++b){
+            size_t next[256];                                                           // where each digit's next value goes
+            size_t total = 0;
+            for(size_t d = 0; d < 256; ++d){
+                next[d] = total;
+                total  += counts[256 * b + d];
+            }
+            auto shift = 8 * b;
+            for(size_t i = 0; i < size; ++i){
+                uint64_t offset = radix_key(from[i]) - low;
+                to[next[(offset >> shift) & 0xff]++] = from[i];
+            }
+            std::swap(from, to);
+        }
+        return from;
+    }
+
+    /**
+     * @brief   build a heap of integers that span at most two bytes of range by
+     *          counting them, with no comparisons and no scratch array
+     * @details Counts each key's offset from the smallest key, and then writes the
+     *          heap one level at a time as `make_heap_from_sorted()` does: each
+     *          min-level is filled with the next values up from the smallest, and
+     *          each max-level with the next values down from the largest, which
+     *          are read off the counts from both ends.
+     *
+     * @param heap_array  the integers (will become a heap)
+     * @param size        the number of integers
+     * @param low         the smallest key, from `radix_bytes()`
+     * @param bytes       the number of bytes of range, from `radix_bytes()` (at most 2)
+     * @tparam  DataType    an integral type
+     */
+    template <typename DataType>
+    void counting_layout(DataType* heap_array, size_t size, typename std::make_unsigned<DataType>::type low, size_t bytes){
+        typedef typename std::make_unsigned<DataType>::type Key;
+        std::vector<size_t> counts(size_t(1) << (8 * bytes), 0);
+        for(size_t i = 0; i < size; ++i){
+            ++counts[radix_key(heap_array[i]) - low];
+        }
+        size_t up   = 0;                                                                // next offsets to take from each end
+        size_t down = counts.size() - 1;
+        for(size_t first = 0, width = 1; first < size; first += width, width *= 2){
+            auto end      = first + std::min(width, size - first);
+            bool from_low = min_level(first);
+            for(auto i = first; i < end; ){
+                auto& offset = from_low ? up : down;
+                while(counts[offset] == 0){
+                    offset = from_low ? offset + 1 : offset - 1;
+                }
+                auto n = std::min(counts[offset], end - i);
+                std::fill_n(heap_array + i, n, DataType(radix_key(DataType(Key(low + offset)))));   // radix_key() is its own inverse
+                counts[offset] -= n;
+                i += n;
+            }
+        }
+    }
+
+    /**
+     * @brief   offer the starting indices for a sorted walk of the heap
+     * @details A sorted walk emits the heap's values in order from one end by
+     *          keeping a small "frontier" of candidate indices.  Walking up from the
+     *          minimum starts at the root; walking down from the maximum starts at
+     *          the first max-level (and the root, which may be the only element).
+     *
+     * @param descending  `true` to walk from the maximum down
+     * @param offer       called with each starting index (which may be past the
+     *                    end of the heap; the caller must check)
+     */
+    template <typename Offer>
+    void sorted_walk_start(bool descending, Offer offer){
+        offer(0);
+        if(descending){
+            offer(1);
+            offer(2);
+        }
+    }
+
+    /**
+     * @brief   offer the indices that become candidates once index `i` is emitted
+     *          by a sorted walk
+     * @details Every value is no further from the walk's end than the value that
+     *          offers it: ascending, a min-level index offers its children (each no
+     *          smaller than it) and grandchildren, and a max-level index offers
+     *          nothing; descending is the mirror image.  Every index is offered
+     *          exactly once, so the frontier never needs to check for duplicates and
+     *          emitting the first `k` values costs O(k log k) regardless of the size
+     *          of the heap.
+     *
+     * @param i           the index that was just emitted
+     * @param descending  `true` if walking from the maximum down
+     * @param offer       called with each new candidate index (which may be past
+     *                    the end of the heap; the caller must check)
+     */
+    template <typename Offer>
+    void sorted_walk_expand(size_t i, bool descending, Offer offer){
+        if(min_level(i) != descending){
+            auto l = left(i);
+            auto r = right(i);
+            offer(l);
+            offer(r);
+            offer(left(l));
+            offer(right(l));
+            offer(left(r));
+            offer(right(r));
+        }
+    }
 }
 
 /**
@@ -443,19 +1096,80 @@ namespace _mmheap{
  * is in this namespace.
  */
 namespace mmheap{
+    /**
+     * @brief   make an array that is already sorted into a heap (in-place)
+     * @details The min-levels take the smallest values and the max-levels the
+     *          largest, so a sorted array becomes a heap by a fixed rearrangement
+     *          that compares no values at all (see `_mmheap::sorted_layout_in_place()`).
+     *
+     * @param heap_array    the sorted array that will become a heap
+     * @param size          the number of elements in the array
+     * @param descending    `true` if the array is sorted in descending order
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      Swappable, MoveConstructible, and MoveAssignable
+     */
+    template <typename DataType>
+    void make_heap_from_sorted_in_place(DataType* heap_array, size_t size, bool descending = false){
+        _mmheap::sorted_layout_in_place(heap_array, size, descending);
+    }
+
+    /**
+     * @brief   copy a sorted array into a heap in one streaming pass
+     * @details Writes the heap one level at a time, front to back: each min-level
+     *          is copied from the low end of the sorted values and each max-level
+     *          from the high end, so `sorted` is read from both ends inward and
+     *          `heap_array` is written sequentially, with no comparisons.
+     *
+     * @param      sorted      the sorted input values
+     * @param      size        the number of input values
+     * @param[out] heap_array  receives the heap (room for `size`; must not overlap `sorted`)
+     * @param      descending  `true` if `sorted` is in descending order
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      CopyAssignable
+     */
+    template <typename DataType>
+    void make_heap_from_sorted(const DataType* sorted, size_t size, DataType* heap_array, bool descending = false){
+        size_t low  = 0;                                                                // unused values are sorted[low, high)
+        size_t high = size;
+        for(size_t first = 0, width = 1; first < size; first += width, width *= 2){
+            auto n        = std::min(width, size - first);
+            bool take_low = _mmheap::min_level(first) != descending;
+            if(take_low){
+                std::copy(sorted + low, sorted + low + n, heap_array + first);
+                low += n;
+            }
+            else{
+                std::copy(sorted + high - n, sorted + high, heap_array + first);
+                high -= n;
+            }
+        }
+    }
+
     /**
      * @brief   make an arbitrary array into a heap (in-place)
      * @details Applies Floyd's algorithm (adapted to a min-max heap) to produce
      *          a heap from an arbitrary array in linear time.
      *
+     *          With `adaptive`, a cheap pre-scan first measures how presorted the
+     *          array is (see `_mmheap::build_presorted()`): sorted input is laid out
+     *          with no comparisons (as by `make_heap_from_sorted_in_place()`), input
+     *          made of a few ascending or descending runs is merged and then laid
+     *          out, and sorted input with a few values out of place is laid out
+     *          without them before they are inserted.  Anything else falls through
+     *          to Floyd's algorithm.
+     *
      * @param heap_array    the array that will become a heap
      * @param size          the number of elements in the array
+     * @param adaptive      `true` to check for presorted input first
      * @tparam  DataType    the type of data stored in the heap - must be
      *                      LessThanComparable, Swappable, CopyConstructable,
      *                      and CopyAssignable
      */
     template <typename DataType>
-    void make_heap(DataType* heap_array, size_t size){
+    void make_heap(DataType* heap_array, size_t size, bool adaptive = false){
+        if(adaptive && _mmheap::build_presorted(heap_array, size)){
+            return;
+        }
         if(size > 1){
             bool finished = false;
             for(size_t current = _mmheap::parent(size-1); !finished; --current){
@@ -465,6 +1179,63 @@ namespace mmheap{
         }
     }
 
+    /**
+     * @brief   make an array of integers into a heap (in-place), by counting or
+     *          radix sorting when that is faster than Floyd's algorithm
+     * @details A first pass finds the range of the values, which decides how many
+     *          bytes of each value a radix sort would have to examine (so 64-bit
+     *          keys that span a narrow range are as cheap as narrow keys):
+     *            * Up to two bytes of range, with no more possible offsets than
+     *              values, the values are counted and written straight into the heap
+     *              layout with no comparisons and no scratch space (see
+     *              `_mmheap::counting_layout()`).
+     *            * Three bytes of range, in an array of `radix_min` values or more
+     *              that is small enough to stay in cache, are LSD radix sorted into
+     *              a scratch array and copied into the heap layout by
+     *              `make_heap_from_sorted()`.
+     *            * Anything else uses Floyd's algorithm.  Each radix scatter pass
+     *              over an array that does not fit in cache costs about as much as
+     *              the whole heapify, and the range scan stops as soon as it knows
+     *              neither fast path applies.
+     *
+     * @param heap_array    the array that will become a heap
+     * @param size          the number of elements in the array
+     * @tparam  DataType    an integral type (other than `bool`)
+     */
+    template <typename DataType>
+    void make_heap_integer(DataType* heap_array, size_t size){
+        static_assert(std::is_integral<DataType>::value && !std::is_same<DataType, bool>::value,
+                      "make_heap_integer requires an integral DataType");
+        const size_t radix_max_bytes = 3;                                               // scatter passes
+        const size_t radix_max_array = size_t(512) << 10;                               // bytes, to stay in cache
+        const size_t radix_min       = 16384;
+        size_t counting_limit = 0;                                                      // bytes of range with no more counters than values
+        while(counting_limit < 2 && size >> (8 * (counting_limit + 1)) > 0){
+            ++counting_limit;
+        }
+        size_t radix_limit = size >= radix_min && size * sizeof(DataType) <= radix_max_array ? radix_max_bytes : 0;
+        typename std::make_unsigned<DataType>::type low = 0;
+        auto bytes = counting_limit > 0 ? _mmheap::radix_bytes(heap_array, size, std::max(counting_limit, radix_limit), low)
+                                        : 1;                                            // too small to be worth scanning
+        if(bytes <= counting_limit){
+            _mmheap::counting_layout(heap_array, size, low, bytes);
+        }
+        else if(bytes <= radix_limit){
+            std::unique_ptr<DataType[]> buffer(new DataType[size]);
+            auto sorted = _mmheap::radix_sort(heap_array, buffer.get(), size, low, bytes);
+            if(sorted == buffer.get()){
+                make_heap_from_sorted(buffer.get(), size, heap_array);
+            }
+            else{
+                make_heap_from_sorted(heap_array, size, buffer.get());
+                std::copy(buffer.get(), buffer.get() + size, heap_array);
+            }
+        }
+        else{
+            make_heap(heap_array, size);
+        }
+    }
+
     /**
      * insert a new value to the heap (and update the `count`)
      *
@@ -488,6 +1259,35 @@ namespace mmheap{
         }
     }
 
+    /**
+     * @brief   insert several new values to the heap at once (and update the `count`)
+     * @details The values are appended to the end of the array and the heap is
+     *          repaired in a single bottom-up pass over the new positions and their
+     *          ancestors, which is cheaper than calling `heap_insert()` once per value
+     *          whenever more than a handful of values are inserted together.
+     *
+     * @param           values       the new values to insert
+     * @param           value_count  the number of values in `values`
+     * @param           heap_array   the heap
+     * @param[in,out]   count        the current number of items in the heap (will update)
+     * @param           max_size     the physical storage allocation size of the heap
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      and CopyAssignable
+     * @throws std::runtime_error if the heap does not have room for all of the values
+     */
+    template <typename DataType>
+    void heap_insert_batch(const DataType* values, size_t value_count, DataType* heap_array, size_t& count, size_t max_size){
+        if(max_size - count < value_count){
+            throw std::runtime_error("Cannot insert into heap - allocated size is too small for batch.");
+        }
+        if(value_count > 0){
+            std::copy(values, values + value_count, heap_array + count);
+            _mmheap::repair_range(heap_array, count, count + value_count - 1, count + value_count - 1);
+            count += value_count;
+        }
+    }
+
     /**
      * get the maximum value in the heap
      *
@@ -570,6 +1370,49 @@ namespace mmheap{
         return std::pair<bool, DataType>{overflowed, max_value};
     }
 
+    /**
+     * @brief   add to heap, rotating the minimum value out if the heap is full
+     * @details The mirror image of `heap_insert_circular()`: once the heap has
+     *          reached its storage capacity it retains the `max_size` largest values
+     *          seen, rather than the smallest.
+     *
+     * @param         value         new value to add
+     * @param         heap_array    the heap
+     * @param[in,out] count         number of values currently in the heap (will update)
+     * @param         max_size      maximum physical size allocated for the heap
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      DefaultConstructable, LessThanComparable, Swappable,
+     *                      CopyConstructable, and CopyAssignable
+     * @return a pair consising of a flag and a value; the first element is a flag
+     *         indicating that overflow occurred, and the second element is the value
+     *         that rotated out of the heap (formerly the minimum) when the new value
+     *         was added (set only if an overflow occurred)
+     */
+    template <typename DataType>
+    std::pair<bool, DataType> heap_insert_circular_min(const DataType& value, DataType* heap_array, size_t& count, size_t max_size){
+        auto min_value  = DataType{};
+        bool overflowed = count == max_size ? true : false;
+        if(!overflowed){
+            heap_insert(value, heap_array, count, max_size);
+        }
+        else{                                                                           // if the heap is full, replace the min value with the new add...
+            min_value = heap_array[0];
+            if(min_value < value){                                                      // if the new value is smaller than the one rotating out, just rotate the new value
+                heap_array[0] = value;
+                if(max_size > 1){                                                       // if this is non-trivial
+                    auto m = _mmheap::max_child(heap_array, 0, max_size-1).second;
+                    if(heap_array[m] < value){                                          // check that the new value isn't the new max
+                        std::swap(heap_array[0], heap_array[m]);                        //  (if it is, make it so)
+                    }
+                    _mmheap::sift_down(heap_array, 0, max_size-1);                      // sift the new item down
+                }
+            }
+            else{
+                min_value = value;
+            }
+        }
+        return std::pair<bool, DataType>{overflowed, min_value};
+    }
 
     /**
      * replace and return the value at a given index with a new value
@@ -595,29 +1438,53 @@ namespace mmheap{
         }
         auto old_value    = heap_array[index];
         heap_array[index] = new_value;
-        if(_mmheap::min_level(index)){
-            if(new_value < old_value){
-                _mmheap::bubble_up_min(heap_array, index);
-            }
-            else{
-                if(_mmheap::has_parent(index) && heap_array[_mmheap::parent(index)] < new_value){
-                    _mmheap::bubble_up(heap_array, index);
-                }
-                _mmheap::sift_down(heap_array, index, count-1);
+        _mmheap::repair_at(heap_array, index, old_value, count-1);
+        return old_value;
+    }
+
+    /**
+     * @brief   replace the values at many indices and repair the heap once
+     * @details Every index refers to the heap as it was before the call, so callers
+     *          that track positions can update many entries without their indices
+     *          shifting underneath them (as they do between repeated calls to
+     *          `heap_replace_at_index()`).  All indices are validated, every value is
+     *          written, and then only the changed indices and the ancestors they put
+     *          out of order are repaired, bottom-up, each exactly once (see
+     *          `_mmheap::repair_indices()`).  When the changed indices are a large
+     *          fraction of the heap, the whole heap is rebuilt with a single
+     *          linear `make_heap()` instead.  If an index appears more than once, the
+     *          last of its new values wins.
+     *
+     * @param heap_array    the heap
+     * @param count         the number of values currently stored in the heap
+     * @param indices       the indices whose values change
+     * @param new_values    the new values (`new_values[i]` is written to `indices[i]`)
+     * @param update_count  the number of entries in `indices` and `new_values`
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      and CopyAssignable
+     * @throws  std::range_error   if any index is out of range (the heap is not modified)
+     */
+    template <typename DataType>
+    void heap_update_indices(DataType* heap_array, size_t count, const size_t* indices, const DataType* new_values, size_t update_count){
+        for(size_t i = 0; i < update_count; ++i){
+            if(indices[i] >= count){
+                throw std::range_error("Index beyond end of heap.");
             }
         }
-        else{
-            if(old_value < new_value){
-                _mmheap::bubble_up_max(heap_array, index);
-            }
-            else{
-                if(_mmheap::has_parent(index) && new_value < heap_array[_mmheap::parent(index)]){
-                    _mmheap::bubble_up(heap_array, index);
-                }
-                _mmheap::sift_down(heap_array, index, count-1);
-            }
+        for(size_t i = 0; i < update_count; ++i){
+            heap_array[indices[i]] = new_values[i];
         }
-        return old_value;
+        if(update_count == 0){
+            return;
+        }
+        if(update_count >= count / 16){                                                 // measured crossover: scattered repairs now cost more than a rebuild
+            make_heap(heap_array, count);
+            return;
+        }
+        auto dirty = _mmheap::sort_indices(indices, update_count, count);
+        std::reverse(dirty.begin(), dirty.end());
+        _mmheap::repair_indices(heap_array, dirty.data(), dirty.size(), count-1);
     }
 
     /**
@@ -646,6 +1513,84 @@ namespace mmheap{
         return old_value;
     }
 
+    /**
+     * @brief   remove the values at many indices at once
+     * @details Every index refers to the heap as it was before the call, so the
+     *          victims' positions do not shift underneath the caller as they do
+     *          between repeated calls to `heap_remove_at_index()`.  The heap is
+     *          compacted by moving surviving tail values into the victims' slots and
+     *          then repaired once, so the cost is proportional to the number of
+     *          victims plus the paths their replacements disturb rather than one
+     *          full repair per victim.  If a large fraction of the heap is removed,
+     *          it is rebuilt with a single linear pass instead.  Duplicate indices are
+     *          removed once.
+     *
+     * @param         indices     the indices to remove
+     * @param         index_count the number of entries in `indices`
+     * @param         heap_array  the heap
+     * @param[in,out] count       current number of values in the heap (will update)
+     * @param         removed     if not null, receives the removed values in
+     *                            ascending index order (room for `index_count`)
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      and CopyAssignable
+     * @return  the number of values removed
+     * @throws  std::range_error   if any index is out of range (the heap is not modified)
+     */
+    template <typename DataType>
+    size_t heap_remove_indices(const size_t* indices, size_t index_count, DataType* heap_array, size_t& count,
+                               DataType* removed = nullptr){
+        for(size_t i = 0; i < index_count; ++i){
+            if(indices[i] >= count){
+                throw std::range_error("Index beyond end of heap.");
+            }
+        }
+        auto victims = _mmheap::sort_indices(indices, index_count, count);
+        if(victims.empty()){
+            return 0;
+        }
+        bool rebuild = count >= 16 && victims.size() >= count / 16;                     // same crossover as heap_update_indices()
+        _mmheap::remove_sorted_indices(heap_array, count, victims.data(), victims.size(), removed, !rebuild);
+        if(rebuild){
+            make_heap(heap_array, count);
+        }
+        return victims.size();
+    }
+
+    /**
+     * @brief   remove every value that matches a predicate
+     * @details Scans the heap once to find the victims, then compacts and repairs
+     *          it once as `heap_remove_indices()` does.
+     *
+     * @param         pred        called with each value; `true` removes it
+     * @param         heap_array  the heap
+     * @param[in,out] count       current number of values in the heap (will update)
+     * @param         removed     if not null, receives the removed values in
+     *                            ascending index order (room for `count`)
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      and CopyAssignable
+     * @return  the number of values removed
+     */
+    template <typename DataType, typename Predicate>
+    size_t heap_remove_if(Predicate pred, DataType* heap_array, size_t& count, DataType* removed = nullptr){
+        std::vector<size_t> victims;
+        for(size_t i = 0; i < count; ++i){
+            if(pred(heap_array[i])){
+                victims.push_back(i);
+            }
+        }
+        if(victims.empty()){
+            return 0;
+        }
+        bool rebuild = count >= 16 && victims.size() >= count / 16;
+        _mmheap::remove_sorted_indices(heap_array, count, victims.data(), victims.size(), removed, !rebuild);
+        if(rebuild){
+            make_heap(heap_array, count);
+        }
+        return victims.size();
+    }
+
     /**
      * remove and return the minimum value in the heap
      *
@@ -699,6 +1644,300 @@ namespace mmheap{
         return value;
     }
 
+    /**
+     * @brief   sort a heap into ascending order (in-place)
+     * @details Repeatedly moves the maximum (always one of the root's children) to
+     *          the back of the shrinking heap.  The element displaced from the back
+     *          lands on the first max-level, so it only needs the same cheap repair
+     *          as `heap_insert_circular()`: one comparison against the root and one
+     *          sift-down, never a bubble-up.
+     *
+     * @param heap_array  the heap (will be sorted, and will no longer be a heap)
+     * @param count       the number of values in the heap
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      and CopyAssignable
+     */
+    template <typename DataType>
+    void sort_heap(DataType* heap_array, size_t count){
+        while(count > 1){
+            auto m = _mmheap::max_child(heap_array, 0, count-1).second;
+            --count;
+            std::swap(heap_array[m], heap_array[count]);                                // the max goes to its final place at the back
+            if(m < count){
+                if(heap_array[m] < heap_array[0]){                                      // the displaced value may be the new min
+                    std::swap(heap_array[0], heap_array[m]);
+                }
+                _mmheap::sift_down(heap_array, m, count-1);
+            }
+        }
+    }
+
+    /**
+     * @brief   find the `k` smallest and the `k` largest values in one pass
+     * @details Reads `values` exactly once, keeping the smallest `k` in one bounded
+     *          heap (`heap_insert_circular()`) and the largest `k` in another
+     *          (`heap_insert_circular_min()`).  Once both heaps are full, a value that
+     *          belongs to neither tail costs two comparisons against cached
+     *          thresholds.  The output arrays are
+     *          used as the heaps' storage, and are sorted at the end.  For a stream
+     *          that isn't available as an array, the same two calls can be made per
+     *          value as it arrives.
+     *
+     * @param      values  the input values
+     * @param      count   the number of input values
+     * @param      k       the size of each tail
+     * @param[out] bottom  receives the smallest `k` values in ascending order (room for `k`)
+     * @param[out] top     receives the largest `k` values in descending order (room for `k`)
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      DefaultConstructable, LessThanComparable, Swappable,
+     *                      CopyConstructable, and CopyAssignable
+     * @return the number of values written to each of `bottom` and `top` (the
+     *         smaller of `k` and `count`)
+     */
+    template <typename DataType>
+    size_t select_tails(const DataType* values, size_t count, size_t k, DataType* bottom, DataType* top){
+        size_t bottom_count = 0;
+        size_t top_count    = 0;
+        size_t i            = 0;
+        if(k > 0){
+            for(; i < count && bottom_count < k; ++i){                                  // fill both heaps
+                heap_insert(values[i], bottom, bottom_count, k);
+                heap_insert(values[i], top,    top_count,    k);
+            }
+            if(i < count){
+                auto bottom_max = heap_max(bottom, bottom_count);                       // thresholds for entering either tail
+                auto top_min    = top[0];
+                for(; i < count; ++i){
+                    if(values[i] < bottom_max){
+                        heap_insert_circular(values[i], bottom, bottom_count, k);
+                        bottom_max = heap_max(bottom, bottom_count);
+                    }
+                    if(top_min < values[i]){
+                        heap_insert_circular_min(values[i], top, top_count, k);
+                        top_min = top[0];
+                    }
+                }
+            }
+        }
+        sort_heap(bottom, bottom_count);
+        sort_heap(top, top_count);
+        std::reverse(top, top + top_count);
+        return bottom_count;
+    }
+
+
+    /**
+     * @brief   a lazy, non-destructive sorted view of a heap
+     * @details Yields the heap's values in ascending or descending order without
+     *          modifying (or copying) the heap, by walking the implicit tree with a
+     *          small frontier heap of indices (see `_mmheap::sorted_walk_expand()`).
+     *          Producing the first `k` values costs O(k log k) time and O(k) space.
+     *          The heap must not be modified while the view is in use.
+     *
+     *          Use `next()` / `empty()` directly, `take()` for a batch, or a range-based
+     *          `for` loop.  Views are created with `sorted_ascending()` and
+     *          `sorted_descending()`.
+     *
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable
+     */
+    template <typename DataType>
+    class sorted_view{
+    public:
+        sorted_view(const DataType* heap_array, size_t count, bool descending)
+            : heap_array{heap_array}, count{count}, descending{descending} {
+            _mmheap::sorted_walk_start(descending, [this](size_t i){ offer(i); });
+        }
+
+        /** `true` once every value has been produced */
+        bool empty() const { return frontier.empty(); }
+
+        /** the next value in order (the view must not be empty) */
+        const DataType& peek() const { return heap_array[frontier.front()]; }
+
+        /**
+         * produce the next value in order
+         *
+         * @throws std::runtime_error if every value has already been produced
+         */
+        const DataType& next(){
+            if(frontier.empty()){
+                throw std::runtime_error("No values left in sorted view.");
+            }
+            std::pop_heap(frontier.begin(), frontier.end(), later{this});
+            auto i = frontier.back();
+            frontier.pop_back();
+            _mmheap::sorted_walk_expand(i, descending, [this](size_t c){ offer(c); });
+            return heap_array[i];
+        }
+
+        /**
+         * produce up to `k` values in order
+         *
+         * @param[out] out  array to receive the values (room for `k`)
+         * @param      k    the largest number of values to produce
+         * @return the number of values written to `out`
+         */
+        size_t take(DataType* out, size_t k){
+            size_t n = 0;
+            while(n < k && !frontier.empty()){
+                out[n++] = next();
+            }
+            return n;
+        }
+
+        /** a single-pass input iterator over the remaining values */
+        class iterator{
+        public:
+            explicit iterator(sorted_view* view) : view{view && !view->empty() ? view : nullptr} {}
+            const DataType& operator*() const { return view->peek(); }
+            iterator& operator++(){
+                view->next();
+                if(view->empty()){
+                    view = nullptr;
+                }
+                return *this;
+            }
+            bool operator==(const iterator& other) const { return view == other.view; }
+            bool operator!=(const iterator& other) const { return view != other.view; }
+        private:
+            sorted_view* view;
+        };
+
+        iterator begin() { return iterator{this};    }
+        iterator end()   { return iterator{nullptr}; }
+
+    private:
+        struct later{                                                                   // frontier ordering: the next value to produce is on top
+            const sorted_view* view;
+            bool operator()(size_t a, size_t b) const {
+                return view->descending ? view->heap_array[a] < view->heap_array[b]
+                                        : view->heap_array[b] < view->heap_array[a];
+            }
+        };
+
+        void offer(size_t i){
+            if(i < count){
+                frontier.push_back(i);
+                std::push_heap(frontier.begin(), frontier.end(), later{this});
+            }
+        }
+
+        const DataType*      heap_array;
+        size_t               count;
+        bool                 descending;
+        std::vector<size_t>  frontier;
+    };
+
+    /**
+     * get a lazy view of the heap's values in ascending order (see `sorted_view`)
+     *
+     * @param heap_array  the heap (must not be modified while the view is in use)
+     * @param count       the number of values in the heap
+     */
+    template <typename DataType>
+    sorted_view<DataType> sorted_ascending(const DataType* heap_array, size_t count){
+        return sorted_view<DataType>{heap_array, count, false};
+    }
+
+    /**
+     * get a lazy view of the heap's values in descending order (see `sorted_view`)
+     *
+     * @param heap_array  the heap (must not be modified while the view is in use)
+     * @param count       the number of values in the heap
+     */
+    template <typename DataType>
+    sorted_view<DataType> sorted_descending(const DataType* heap_array, size_t count){
+        return sorted_view<DataType>{heap_array, count, true};
+    }
+
+    /**
+     * @brief   an incremental (deamortized) `make_heap()`
+     * @details Performs Floyd's construction a bounded number of sift-downs at a
+     *          time, so that building a very large heap never blocks the caller
+     *          for longer than one `step()`.  Each sift-down costs O(log n), so a
+     *          call to `step(max_sifts)` does O(max_sifts * log n) work.
+     *
+     *          Values may be inserted while the build is in progress: they are
+     *          appended after the values being built and are bubbled up, one per
+     *          sift of budget, once the rest of the heap is ready - exactly as
+     *          `heap_insert()` would have placed them.  Once `ready()` returns
+     *          `true`, `heap_array[0, size())` is an ordinary heap and the other
+     *          `mmheap` functions can be used on it directly.
+     *
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      and CopyAssignable
+     */
+    template <typename DataType>
+    class heap_builder{
+    public:
+        /**
+         * @param heap_array  the array to make into a heap (owned by the caller)
+         * @param count       the number of values already in the array
+         * @param max_size    the physical storage allocation size of the array
+         */
+        heap_builder(DataType* heap_array, size_t count, size_t max_size)
+            : heap_array{heap_array}, count{count}, max_size{max_size},
+              build_count{count}, next_sift{count > 1 ? _mmheap::parent(count-1) + 1 : 0}, next_bubble{count} {}
+
+        /**
+         * advance the build by at most `max_sifts` sift-down (or bubble-up) operations
+         *
+         * @return `true` if the heap is now ready
+         */
+        bool step(size_t max_sifts){
+            for(; max_sifts > 0 && !ready(); --max_sifts){
+                if(next_sift > 0){
+                    --next_sift;
+                    _mmheap::sift_down(heap_array, next_sift, build_count-1);
+                }
+                else{
+                    _mmheap::bubble_up(heap_array, next_bubble++);                      // a value inserted during the build
+                }
+            }
+            return ready();
+        }
+
+        /** complete the build now */
+        void finish(){
+            while(!step(next_sift + (count - next_bubble))){}
+        }
+
+        /**
+         * insert a new value (deferred until the build reaches it, if not yet ready)
+         *
+         * @throws std::runtime_error if the heap is full prior to the insert operation
+         */
+        void insert(const DataType& value){
+            if(ready()){
+                heap_insert(value, heap_array, count, max_size);
+                next_bubble = count;
+            }
+            else if(count < max_size){
+                heap_array[count++] = value;
+            }
+            else{
+                throw std::runtime_error("Cannot insert into heap - allocated size is full.");
+            }
+        }
+
+        /** `true` once `heap_array[0, size())` is a complete heap */
+        bool ready() const { return next_sift == 0 && next_bubble == count; }
+
+        /** the number of values in the array (built or pending) */
+        size_t size() const { return count; }
+
+    private:
+        DataType* heap_array;
+        size_t    count;
+        size_t    max_size;
+        size_t    build_count;                                                          // values present when the build started
+        size_t    next_sift;                                                            // Floyd's pass works down from here to 0
+        size_t    next_bubble;                                                          // next value inserted during the build
+    };
+
     /**
      * determine if an arbitrary array is a Min-Max heap
      *
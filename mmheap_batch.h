@@ -0,0 +1,644 @@
+#ifndef MMHEAP_BATCH_H
+#define MMHEAP_BATCH_H
+/**
+ * @file mmheap_batch.h
+ *
+ * Defines batched operations across many independent Min-Max Heaps (see `mmheap.h`).
+ *
+ * @details
+ *   A sift on a large heap is a chain of dependent loads: the next node to visit
+ *   isn't known until the current one has arrived from memory.  When the same
+ *   operation has to be applied to many independent heaps, the functions in this
+ *   file run one explicit sift state machine per heap, advance them round-robin
+ *   one level at a time, and prefetch the nodes each one will need next, so that
+ *   the cache misses of different heaps overlap instead of being paid one after
+ *   another.
+ *
+ * @license   Released under the MIT License: http://opensource.org/licenses/MIT
+ * @copyright Copyright (c) 2015 Jason L Causey, Arkansas State University
+ */
+
+#include "mmheap.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Internal helpers for the batched operations.
+ */
+namespace _mmheap{
+
+    /**
+     * hint that `address` will be read soon (no effect on compilers without a
+     * prefetch builtin)
+     */
+    inline void prefetch(const void* address){
+#if defined(__GNUC__)
+        __builtin_prefetch(address);
+#else
+        (void)address;
+#endif
+    }
+
+    /**
+     * prefetch the children and grandchildren of index `i`, which the next sift-down
+     * step from `i` will compare
+     */
+    template <typename DataType>
+    void prefetch_below(const DataType* heap_array, size_t i, size_t right_index){
+        if(left(i) <= right_index){
+            prefetch(heap_array + left(i));
+            auto gchildren = left(left(i));
+            if(gchildren <= right_index){
+                prefetch(heap_array + gchildren);
+                prefetch(heap_array + std::min(gchildren + 3, right_index));           // the four grandchildren may straddle two lines
+            }
+        }
+    }
+
+    /**
+     * @brief   the state of one resumable heap operation in a batch
+     * @details Each call to `step()` performs one level of a sift-down (or
+     *          bubble-up) and prefetches what the following level will touch, then
+     *          returns so that the executor can advance other heaps while that
+     *          memory arrives.
+     */
+    template <typename DataType>
+    struct batch_lane{
+        enum class phase{ idle, start, sift_min, sift_max, bubble_min, bubble_max };
+
+        DataType* heap_array;
+        size_t*   count;
+        size_t    index;
+        phase     state;
+
+        /** advance one level; returns `false` once the operation is complete */
+        bool step(){
+            switch(state){
+                case phase::sift_min:
+                case phase::sift_max:
+                    return sift_step(state == phase::sift_min);
+                case phase::bubble_min:
+                case phase::bubble_max:
+                    return bubble_step(state == phase::bubble_min);
+                default:
+                    return false;
+            }
+        }
+
+        bool sift_step(bool min){                                                       // one iteration of `sift_down_min()` / `sift_down_max()`
+            auto right_index = *count - 1;
+            if(*count == 0 || left(index) > right_index){
+                return false;
+            }
+            auto m = min ? min_child_or_gchild(heap_array, index, right_index).second
+                         : max_child_or_gchild(heap_array, index, right_index).second;
+            if(!(min ? heap_array[m] < heap_array[index] : heap_array[index] < heap_array[m])){
+                return false;
+            }
+            std::swap(heap_array[m], heap_array[index]);
+            if(child(index, m)){
+                return false;
+            }
+            if(min ? heap_array[parent(m)] < heap_array[m] : heap_array[m] < heap_array[parent(m)]){
+                std::swap(heap_array[m], heap_array[parent(m)]);
+            }
+            index = m;
+            prefetch_below(heap_array, index, right_index);
+            return true;
+        }
+
+        bool bubble_step(bool min){                                                     // one iteration of `bubble_up_min()` / `bubble_up_max()`
+            if(!has_gparent(index)){
+                return false;
+            }
+            auto gp = gparent(index);
+            if(!(min ? heap_array[index] < heap_array[gp] : heap_array[gp] < heap_array[index])){
+                return false;
+            }
+            std::swap(heap_array[index], heap_array[gp]);
+            index = gp;
+            if(has_gparent(index)){
+                prefetch(heap_array + gparent(index));
+            }
+            return true;
+        }
+    };
+
+    /**
+     * @brief   run one operation on each of many heaps, interleaved across `lanes`
+     *          in-flight state machines
+     *
+     * @param heap_count  number of heaps
+     * @param lanes       number of operations in flight at once
+     * @param queue       called as `queue(h)` when heap `h` is assigned a lane (prefetch only)
+     * @param start       called as `start(h, lane)` one round later to perform the
+     *                    operation's O(1) setup and choose the lane's phase
+     */
+    template <typename DataType, typename Queue, typename Start>
+    void run_batch(size_t heap_count, size_t lanes, Queue queue, Start start){
+        typedef typename batch_lane<DataType>::phase phase;
+        std::vector<batch_lane<DataType>> lane(std::max<size_t>(1, lanes));
+        std::vector<size_t>               heap_of(lane.size());
+        size_t next   = 0;
+        size_t active = 0;
+        for(auto& l : lane){
+            l.state = phase::idle;
+        }
+        do{
+            active = 0;
+            for(size_t k = 0; k < lane.size(); ++k){
+                auto& l = lane[k];
+                if(l.state == phase::start){
+                    start(heap_of[k], l);
+                }
+                else if(l.state != phase::idle && !l.step()){
+                    l.state = phase::idle;
+                }
+                if(l.state == phase::idle && next < heap_count){                        // refill: prefetch now, start next round
+                    heap_of[k] = next;
+                    queue(next++);
+                    l.state = phase::start;
+                }
+                active += l.state != phase::idle;
+            }
+        } while(active > 0);
+    }
+
+#if defined(__AVX512F__)
+    const size_t vector_bytes = 64;                                                     // the widest vector the target handles natively
+#elif defined(__AVX2__)
+    const size_t vector_bytes = 32;
+#else
+    const size_t vector_bytes = 16;                                                     // SSE2, NEON, ...
+#endif
+
+    /**
+     * whether `transposed_insert_circular()` can run on vectors of `DataType`
+     * (otherwise `mmheap::transposed_heaps` falls back to one heap at a time)
+     */
+    template <typename DataType>
+    struct transposed_vectorized : std::integral_constant<bool,
+#if defined(__GNUC__)
+        std::is_arithmetic<DataType>::value && !std::is_same<DataType, bool>::value && sizeof(DataType) <= 8
+#else
+        false
+#endif
+    > {};
+
+#if defined(__GNUC__)
+    /** signed integer as wide as a key, for per-lane masks and node indices */
+    template <size_t Size> struct lane_int;
+    template <> struct lane_int<1>{ typedef int8_t  type; };
+    template <> struct lane_int<2>{ typedef int16_t type; };
+    template <> struct lane_int<4>{ typedef int32_t type; };
+    template <> struct lane_int<8>{ typedef int64_t type; };
+
+    /**
+     * @brief   `heap_insert_circular()` on `Bytes / sizeof(DataType)` transposed
+     *          heaps, one per vector lane (see `mmheap::transposed_heaps`)
+     * @details Written with the GCC/Clang vector extensions, which map onto whatever
+     *          SIMD the target has.  Row `r` of the block is one vector, and a
+     *          lane's node `i` is reached by selecting across rows where `i == r`,
+     *          so there are no gathers and no data-dependent branches.
+     *
+     * @param       rows          the first heap's column of the block
+     * @param       stride        values per row of the block (at least one vector)
+     * @param[in,out] counts      the block's counts (will update)
+     * @param       in            one value per heap
+     * @param[out]  out           the value rotated out of each heap (`DataType{}` if
+     *                            it was not yet full)
+     * @param       capacity      values per heap (1 to 16)
+     * @tparam      Bytes         the vector size: a power of two no wider than the
+     *                            target's `vector_bytes`
+     */
+    template <typename DataType, size_t Bytes>
+    void transposed_insert_circular(DataType* rows, size_t stride, unsigned* counts, const DataType* in, DataType* out,
+                                    unsigned capacity){
+        typedef DataType                                  values __attribute__((vector_size(Bytes)));
+        typedef typename lane_int<sizeof(DataType)>::type index;
+        typedef index                                     lanes  __attribute__((vector_size(Bytes)));
+        const unsigned width = Bytes / sizeof(DataType);
+
+        auto select = [](values& result, const values* tile, lanes idx, unsigned first, unsigned last){
+            result = tile[first];                                                       // lane l gets tile[idx[l]][l], for idx[l] in [first, last)
+            for(unsigned r = first + 1; r < last; ++r){
+                result = idx == index(r) ? tile[r] : result;
+            }
+        };
+        auto store = [](values* tile, lanes idx, lanes mask, values value, unsigned first, unsigned last){
+            for(unsigned r = first; r < last; ++r){                                     // tile[idx[l]][l] = value[l] where mask[l]
+                tile[r] = (mask & (idx == index(r))) != 0 ? value : tile[r];
+            }
+        };
+        auto any = [](lanes mask){
+            unsigned char bytes[Bytes];
+            unsigned char result = 0;
+            std::memcpy(bytes, &mask, sizeof(mask));
+            for(auto byte : bytes){
+                result |= byte;
+            }
+            return result != 0;
+        };
+
+        values tile[16];
+        values value, other, incoming;
+        lanes  count, hole, best, next, moved, found, dir_min;
+        lanes  zero = {};
+        for(unsigned r = 0; r < capacity; ++r){
+            std::memcpy(&tile[r], rows + stride*r, sizeof(values));
+        }
+        std::memcpy(&incoming, in, sizeof(values));
+        for(unsigned l = 0; l < width; ++l){
+            count[l] = index(counts[l]);
+        }
+        index r1 = capacity > 1 ? 1 : 0;
+        index r2 = capacity > 2 ? 2 : r1;
+        lanes full      = count == index(capacity);                                     // full heaps replace their max; others append
+        lanes right_max = tile[r1] < tile[r2];
+        lanes m         = right_max != 0 ? zero + r2 : zero + r1;
+        values vm       = right_max != 0 ? tile[r2] : tile[r1];
+        lanes replace   = full & (incoming < vm);
+        lanes swap_root = replace & (m != 0) & (incoming < tile[0]);                    // the new value is also the new min
+        values kept     = full != 0 ? incoming : values{};
+        values outgoing = replace != 0 ? vm : kept;
+        value           = swap_root != 0 ? tile[0] : incoming;
+        tile[0]         = swap_root != 0 ? incoming : tile[0];
+        hole            = full != 0 ? m : count;
+        lanes sifting   = replace;
+        lanes bubbling  = ~full & (count > 0);
+        lanes placing   = replace | ~full;
+        count          -= ~full;                                                        // ~full is -1 where a value was appended
+        std::memcpy(out, &outgoing, sizeof(values));
+        for(unsigned l = 0; l < width; ++l){
+            counts[l] = unsigned(count[l]);
+        }
+        if(!any(placing)){
+            return;
+        }
+        if(any(bubbling)){                                                              // `bubble_up()`: first the parent decides the direction...
+            next  = bubbling != 0 ? (hole - 1) / 2 : zero;
+            select(other, tile, next, 0, capacity);
+            lanes h1  = hole + 1;
+            lanes min = (h1 == 1) | ((h1 >= 4) & (h1 < 8)) | (h1 >= 16);              // `min_level()` for the five levels of a 16-value heap
+            moved   = bubbling & ((min != 0 ? other : value) < (min != 0 ? value : other));
+            dir_min = moved != 0 ? ~min : min;
+            store(tile, hole, moved, other, 0, capacity);
+            hole = moved != 0 ? next : hole;
+            for(int step = 0; step < 2; ++step){                                        // ...then at most two grandparent steps reach the root
+                bubbling &= hole > 2;
+                next      = bubbling != 0 ? ((hole - 1) / 2 - 1) / 2 : zero;
+                select(other, tile, next, 0, capacity);
+                moved     = bubbling & ((dir_min != 0 ? value : other) < (dir_min != 0 ? other : value));
+                bubbling  = moved;
+                store(tile, hole, moved, other, 0, capacity);
+                hole = moved != 0 ? next : hole;
+            }
+        }
+        for(unsigned level = 1; level < 5 && any(sifting); level += 2){                 // `sift_down_max()` from level 1, two levels per step
+            found = zero;
+            best  = zero;
+            other = value;
+            for(unsigned r = (2u << level) - 1; r < capacity; ++r){                     // scan the children and grandchildren, in index order
+                index p  = index((r - 1) / 2);
+                index gp = r > 2 ? index((p - 1) / 2) : index(capacity);
+                lanes candidate = sifting & ((hole == p) | (hole == gp));
+                lanes better    = candidate & (~found | (other < tile[r]));
+                other  = better != 0 ? tile[r] : other;
+                best   = better != 0 ? zero + index(r) : best;
+                found |= candidate;
+            }
+            auto level_first = (1u << level) - 1;                                       // the rows of the holes' level, and of the level below
+            auto below_first = std::min(capacity, (2u << level) - 1);
+            auto below_last  = std::min(capacity, (4u << level) - 1);
+            moved = found & (value < other);
+            store(tile, hole, moved, other, level_first, below_first);
+            sifting = moved & (best > 2*hole + 2);                                      // moving to a child ends the sift
+            hole    = moved != 0 ? best : hole;
+            if(any(sifting)){                                                           // a grandchild move may leave the value below its new parent
+                next = sifting != 0 ? (hole - 1) / 2 : zero;
+                select(other, tile, next, below_first, below_last);
+                moved = sifting & (value < other);
+                store(tile, next, moved, value, below_first, below_last);
+                value = moved != 0 ? other : value;
+            }
+        }
+        store(tile, hole, placing, value, 0, capacity);
+        for(unsigned r = 0; r < capacity; ++r){
+            std::memcpy(rows + stride*r, &tile[r], sizeof(values));
+        }
+    }
+#endif
+}
+
+namespace mmheap{
+
+    /**
+     * @brief   remove the minimum value from each of many heaps
+     * @details Equivalent to calling `heap_remove_min(heaps[h], counts[h])` for every
+     *          `h`, but with the sift-downs of up to `lanes` heaps interleaved so that
+     *          their cache misses overlap (see the file description).  Each heap
+     *          must appear only once per call.
+     *
+     * @param         heaps       the heaps
+     * @param[in,out] counts      the number of values in each heap (will update)
+     * @param         heap_count  the number of heaps
+     * @param[out]    out         receives each heap's minimum (`out[h]` for `heaps[h]`)
+     * @param         lanes       number of heaps in flight at once
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      and CopyAssignable
+     * @throws std::runtime_error if any heap is empty (the heaps are not modified)
+     */
+    template <typename DataType>
+    void heap_remove_min_batch(DataType* const* heaps, size_t* counts, size_t heap_count, DataType* out, size_t lanes = 16){
+        for(size_t h = 0; h < heap_count; ++h){
+            if(counts[h] == 0){
+                throw std::runtime_error("Cannot remove from empty heap.");
+            }
+        }
+        typedef _mmheap::batch_lane<DataType> lane;
+        _mmheap::run_batch<DataType>(heap_count, lanes,
+            [&](size_t h){
+                _mmheap::prefetch(heaps[h]);
+                _mmheap::prefetch(heaps[h] + counts[h] - 1);
+            },
+            [&](size_t h, lane& l){
+                auto heap_array = heaps[h];
+                out[h] = heap_array[0];
+                heap_array[0] = heap_array[--counts[h]];
+                l.heap_array = heap_array;
+                l.count      = &counts[h];
+                l.index      = 0;
+                l.state      = lane::phase::sift_min;
+                _mmheap::prefetch_below(heap_array, 0, counts[h] - 1);
+            });
+    }
+
+    /**
+     * @brief   remove the maximum value from each of many heaps
+     * @details Equivalent to calling `heap_remove_max(heaps[h], counts[h])` for every
+     *          `h`, interleaved as `heap_remove_min_batch()` is.  Each heap must appear
+     *          only once per call.
+     *
+     * @param         heaps       the heaps
+     * @param[in,out] counts      the number of values in each heap (will update)
+     * @param         heap_count  the number of heaps
+     * @param[out]    out         receives each heap's maximum (`out[h]` for `heaps[h]`)
+     * @param         lanes       number of heaps in flight at once
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      and CopyAssignable
+     * @throws std::runtime_error if any heap is empty (the heaps are not modified)
+     */
+    template <typename DataType>
+    void heap_remove_max_batch(DataType* const* heaps, size_t* counts, size_t heap_count, DataType* out, size_t lanes = 16){
+        for(size_t h = 0; h < heap_count; ++h){
+            if(counts[h] == 0){
+                throw std::runtime_error("Cannot remove from empty heap.");
+            }
+        }
+        typedef _mmheap::batch_lane<DataType> lane;
+        _mmheap::run_batch<DataType>(heap_count, lanes,
+            [&](size_t h){
+                _mmheap::prefetch(heaps[h]);
+                _mmheap::prefetch(heaps[h] + counts[h] - 1);
+            },
+            [&](size_t h, lane& l){
+                auto heap_array = heaps[h];
+                auto m          = _mmheap::max_child(heap_array, 0, counts[h] - 1);
+                auto i          = m.first ? m.second : 0;
+                out[h] = heap_array[i];
+                heap_array[i] = heap_array[--counts[h]];
+                l.heap_array = heap_array;
+                l.count      = &counts[h];
+                l.index      = i;
+                l.state      = lane::phase::idle;
+                if(i < counts[h]){                                                      // the moved value can only be out of order with the root, or below
+                    if(heap_array[i] < heap_array[0]){
+                        std::swap(heap_array[i], heap_array[0]);
+                    }
+                    l.state = lane::phase::sift_max;
+                    _mmheap::prefetch_below(heap_array, i, counts[h] - 1);
+                }
+            });
+    }
+
+    /**
+     * @brief   insert one value into each of many heaps
+     * @details Equivalent to calling `heap_insert(values[h], heaps[h], counts[h],
+     *          max_sizes[h])` for every `h`, with the bubble-ups interleaved as in
+     *          `heap_remove_min_batch()`.  Each heap must appear only once per call.
+     *
+     * @param         values      the values to insert (`values[h]` goes into `heaps[h]`)
+     * @param         heaps       the heaps
+     * @param[in,out] counts      the number of values in each heap (will update)
+     * @param         max_sizes   the physical storage allocation size of each heap
+     * @param         heap_count  the number of heaps
+     * @param         lanes       number of heaps in flight at once
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      and CopyAssignable
+     * @throws std::runtime_error if any heap is full (the heaps are not modified)
+     */
+    template <typename DataType>
+    void heap_insert_batch_across(const DataType* values, DataType* const* heaps, size_t* counts, const size_t* max_sizes,
+                                  size_t heap_count, size_t lanes = 16){
+        for(size_t h = 0; h < heap_count; ++h){
+            if(counts[h] >= max_sizes[h]){
+                throw std::runtime_error("Cannot insert into heap - allocated size is full.");
+            }
+        }
+        typedef _mmheap::batch_lane<DataType> lane;
+        _mmheap::run_batch<DataType>(heap_count, lanes,
+            [&](size_t h){
+                _mmheap::prefetch(heaps[h] + counts[h]);
+                if(counts[h] > 0){
+                    _mmheap::prefetch(heaps[h] + _mmheap::parent(counts[h]));
+                }
+            },
+            [&](size_t h, lane& l){
+                auto heap_array = heaps[h];
+                auto i          = counts[h]++;
+                heap_array[i] = values[h];
+                l.heap_array = heap_array;
+                l.count      = &counts[h];
+                l.state      = lane::phase::idle;
+                if(i == 0){
+                    return;
+                }
+                auto p   = _mmheap::parent(i);
+                bool min = _mmheap::min_level(i);                                       // the first comparison picks the direction, as in `bubble_up()`
+                if(min ? heap_array[p] < heap_array[i] : heap_array[i] < heap_array[p]){
+                    std::swap(heap_array[i], heap_array[p]);
+                    i   = p;
+                    min = !min;
+                }
+                l.index = i;
+                l.state = min ? lane::phase::bubble_min : lane::phase::bubble_max;
+                if(_mmheap::has_gparent(i)){
+                    _mmheap::prefetch(heap_array + _mmheap::gparent(i));
+                }
+            });
+    }
+
+    /**
+     * @brief   many small heaps of one capacity, stored transposed for SIMD updates
+     * @details The heaps are grouped in blocks of `Lanes`.  Each block is stored as
+     *          `capacity` rows of `Lanes` values, where row `i` holds node `i` of
+     *          every heap in the block side by side.  The block size is fixed by the
+     *          template argument rather than by the target's vector width, so
+     *          translation units built with different `-march` flags agree on the
+     *          layout; the width only decides how many heaps of a block are updated
+     *          per native SIMD vector (16 `uint32_t`s with AVX-512, 8 with AVX2, 4
+     *          with SSE2 or NEON).  `insert_circular()` updates those heaps with one
+     *          instruction stream, one heap per lane.  A lane's current sift position differs from heap to
+     *          heap, so it is reached by comparing each row's index with the lane's
+     *          index and selecting.  No gathers are needed, and no branch depends
+     *          on the data.
+     *
+     *          The vector code uses the GCC/Clang vector extensions, for arithmetic
+     *          `DataType`s.  Other types and compilers update the heaps of a block
+     *          one at a time with `heap_insert_circular()`.  A block costs the same
+     *          whether one lane sifts or all of them do, so this pays off when most
+     *          inserts replace a value, and most on wide vectors.
+     *
+     *          Every operation leaves each heap exactly as the corresponding
+     *          `mmheap` function would on a plain array; `copy_heap()` extracts one
+     *          heap in the ordinary layout.
+     *
+     * @tparam  DataType    the type of data stored in the heaps - must be
+     *                      DefaultConstructable, LessThanComparable,
+     *                      CopyConstructable, and CopyAssignable
+     * @tparam  Lanes       heaps per block - a power of two
+     */
+    template <typename DataType, unsigned Lanes = 16>
+    class transposed_heaps{
+        static_assert(Lanes > 0 && (Lanes & (Lanes - 1)) == 0, "transposed_heaps requires a power-of-two Lanes");
+    public:
+        static const unsigned lanes = Lanes;
+
+        /**
+         * @param heap_count  number of (initially empty) heaps
+         * @param capacity    maximum number of values in each heap (at most 16)
+         * @throws std::range_error if `capacity` is zero or greater than 16
+         */
+        transposed_heaps(size_t heap_count, size_t capacity)
+            : heaps{heap_count}, cap{static_cast<unsigned>(capacity)},
+              padded{(heap_count + lanes - 1) / lanes * lanes} {
+            if(capacity == 0 || capacity > 16){
+                throw std::range_error("Cannot create transposed heaps with a capacity outside 1..16.");
+            }
+            values.resize(padded * cap);
+            counts.resize(padded, 0);
+        }
+
+        /**
+         * @brief   add one value to every heap, as `heap_insert_circular()` would
+         *
+         * @param       in           the values to add (`in[h]` goes into heap `h`)
+         * @param[out]  rotated_out  if not null, receives the value rotated out of
+         *                           each heap (`DataType{}` for heaps that were not
+         *                           yet full)
+         */
+        void insert_circular(const DataType* in, DataType* rotated_out = nullptr){
+            DataType in_block[lanes];
+            DataType out_block[lanes];
+            for(size_t base = 0; base < padded; base += lanes){
+                auto n = std::min<size_t>(lanes, heaps - std::min(heaps, base));        // real heaps in this block (the rest is padding)
+                for(unsigned l = 0; l < lanes; ++l){
+                    in_block[l] = l < n ? in[base + l] : DataType{};
+                }
+                insert_block(values.data() + base * cap, counts.data() + base, in_block, out_block);
+                if(rotated_out){
+                    std::copy(out_block, out_block + n, rotated_out + base);
+                }
+            }
+        }
+
+        size_t count(size_t h) const { return counts[h]; }
+
+        /**
+         * @return the minimum value in heap `h`
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType min(size_t h) const {
+            if(counts[h] == 0){
+                throw std::runtime_error("Cannot get min value in empty heap.");
+            }
+            return values[at(h, 0)];
+        }
+
+        /**
+         * @return the maximum value in heap `h`
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType max(size_t h) const {
+            if(counts[h] == 0){
+                throw std::runtime_error("Cannot get max value in empty heap.");
+            }
+            size_t m = counts[h] < 2 ? 0 : counts[h] > 2 && values[at(h, 1)] < values[at(h, 2)] ? 2 : 1;
+            return values[at(h, m)];
+        }
+
+        /**
+         * copy heap `h` into `out` in the ordinary `mmheap` layout
+         *
+         * @return the number of values copied
+         */
+        size_t copy_heap(size_t h, DataType* out) const {
+            for(size_t i = 0; i < counts[h]; ++i){
+                out[i] = values[at(h, i)];
+            }
+            return counts[h];
+        }
+
+        size_t heap_count() const { return heaps; }
+        size_t capacity()   const { return cap;   }
+
+    private:
+        /** position of node `i` of heap `h` in `values` */
+        size_t at(size_t h, size_t i) const { return ((h / lanes) * cap + i) * lanes + h % lanes; }
+
+        /** `heap_insert_circular()` on the `lanes` heaps of the block at `rows` */
+        void insert_block(DataType* rows, unsigned* block_counts, const DataType* in, DataType* out){
+            insert_block(rows, block_counts, in, out, _mmheap::transposed_vectorized<DataType>{});
+        }
+
+#if defined(__GNUC__)
+        void insert_block(DataType* rows, unsigned* block_counts, const DataType* in, DataType* out, std::true_type){
+            const size_t bytes = _mmheap::vector_bytes < lanes * sizeof(DataType)      // one native vector, or the whole block if narrower
+                               ? _mmheap::vector_bytes : lanes * sizeof(DataType);
+            for(unsigned l = 0; l < lanes; l += bytes / sizeof(DataType)){
+                _mmheap::transposed_insert_circular<DataType, bytes>(rows + l, lanes, block_counts + l, in + l, out + l, cap);
+            }
+        }
+#endif
+
+        void insert_block(DataType* rows, unsigned* block_counts, const DataType* in, DataType* out, std::false_type){
+            DataType heap_array[16];                                                    // one heap at a time, through an ordinary copy
+            for(unsigned l = 0; l < lanes; ++l){
+                size_t count = block_counts[l];
+                for(size_t i = 0; i < count; ++i){
+                    heap_array[i] = rows[i*lanes + l];
+                }
+                out[l] = heap_insert_circular(in[l], heap_array, count, cap).second;
+                for(size_t i = 0; i < count; ++i){
+                    rows[i*lanes + l] = heap_array[i];
+                }
+                block_counts[l] = static_cast<unsigned>(count);
+            }
+        }
+
+        size_t                 heaps;
+        unsigned               cap;
+        size_t                 padded;                                                  // heaps rounded up to whole blocks of `lanes`
+        std::vector<DataType>  values;
+        std::vector<unsigned>  counts;
+    };
+}
+
+#endif
@@ -0,0 +1,1200 @@
+#ifndef MMHEAP_CONCURRENT_H
+#define MMHEAP_CONCURRENT_H
+/**
+ * @file mmheap_concurrent.h
+ *
+ * Defines wrappers for sharing a Min-Max Heap (see `mmheap.h`) between threads.
+ *
+ * @details
+ *   The functions in `mmheap.h` work in-place on a plain C++ array and do no
+ *   synchronization of their own.  The types in this file add the thread-safety
+ *   layer on top of them, without changing the underlying heap layout; the heap
+ *   array is still owned (allocated) by the caller.
+ *
+ * @license   Released under the MIT License: http://opensource.org/licenses/MIT
+ * @copyright Copyright (c) 2015 Jason L Causey, Arkansas State University
+ */
+
+#include "mmheap.h"
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+/**
+ * Internal helpers for the thread-safe wrappers.
+ */
+namespace _mmheap{
+
+    /**
+     * @brief   a single-writer sequence lock holding one value
+     * @details The value is stored as relaxed atomic words, so that readers racing
+     *          with the writer never cause a data race; the sequence counter tells
+     *          readers whether the words they copied are consistent.  Readers never
+     *          block the writer; a reader retries only if a write overlapped its copy.
+     *
+     * @tparam  DataType    the type of data stored - must be TriviallyCopyable
+     */
+    template <typename DataType>
+    class seqlock_value{
+        static_assert(std::is_trivially_copyable<DataType>::value,
+                      "seqlock_value requires a trivially copyable DataType");
+        static const size_t word_count = (sizeof(DataType) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    public:
+        seqlock_value() : sequence{0} {
+            for(auto& w : words){
+                w.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * publish a new value (must only be called by the single writer)
+         *
+         * @param value  the value to publish
+         */
+        void store(const DataType& value){
+            uint64_t buffer[word_count] = {};
+            std::memcpy(buffer, &value, sizeof(DataType));
+            auto s = sequence.load(std::memory_order_relaxed);
+            sequence.store(s + 1, std::memory_order_relaxed);                           // odd: write in progress
+            std::atomic_thread_fence(std::memory_order_release);
+            for(size_t w = 0; w < word_count; ++w){
+                words[w].store(buffer[w], std::memory_order_relaxed);
+            }
+            sequence.store(s + 2, std::memory_order_release);                           // even: consistent again
+        }
+
+        /**
+         * read a consistent copy of the published value
+         *
+         * @param[out] value  receives the copy
+         */
+        void load(DataType& value) const {
+            uint64_t buffer[word_count];
+            uint64_t before, after;
+            do{
+                before = sequence.load(std::memory_order_acquire);
+                for(size_t w = 0; w < word_count; ++w){
+                    buffer[w] = words[w].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = sequence.load(std::memory_order_relaxed);
+            }while(before != after || (before & 1) != 0);
+            std::memcpy(&value, buffer, sizeof(DataType));
+        }
+
+    private:
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> words[word_count];
+    };
+
+    /**
+     * @brief   a bounded lock-free multi-producer, single-consumer ring buffer
+     * @details Each slot carries a sequence number that tells producers when the
+     *          slot is free and the consumer when it has been filled (after Dmitry
+     *          Vyukov's bounded queue).  Producers claim slots with a single CAS and
+     *          never wait on each other's writes to finish; a full ring is reported
+     *          to the producer rather than waited on.
+     *
+     * @tparam  DataType    the type of data stored - must be DefaultConstructable
+     *                      and CopyAssignable
+     */
+    template <typename DataType>
+    class mpsc_ring{
+    public:
+        /**
+         * @param capacity  number of slots (rounded up to a power of two)
+         */
+        explicit mpsc_ring(size_t capacity)
+            : mask{round_up_pow2(capacity) - 1}, slots(mask + 1), enqueue_pos{0}, dequeue_pos{0} {
+            for(size_t i = 0; i <= mask; ++i){
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * add a value (any thread)
+         *
+         * @param value  the value to add
+         * @return `false` if the ring was full
+         */
+        bool try_push(const DataType& value){
+            auto pos = enqueue_pos.load(std::memory_order_relaxed);
+            slot* target;
+            while(true){
+                target    = &slots[pos & mask];
+                auto seq  = target->sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if(diff == 0){
+                    if(enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                        break;
+                    }
+                }
+                else if(diff < 0){
+                    return false;
+                }
+                else{
+                    pos = enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+            target->value = value;
+            target->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * remove up to `max_count` values in FIFO order (consumer thread only)
+         *
+         * @param[out] out        array to receive the values (room for `max_count`)
+         * @param      max_count  the largest number of values to remove
+         * @return the number of values written to `out`
+         */
+        size_t pop_batch(DataType* out, size_t max_count){
+            size_t n = 0;
+            while(n < max_count){
+                auto& source = slots[dequeue_pos & mask];
+                if(source.sequence.load(std::memory_order_acquire) != dequeue_pos + 1){
+                    break;                                                              // empty (or next producer hasn't finished writing)
+                }
+                out[n++] = source.value;
+                source.sequence.store(dequeue_pos + mask + 1, std::memory_order_release);
+                ++dequeue_pos;
+            }
+            return n;
+        }
+
+        size_t capacity() const { return mask + 1; }
+
+    private:
+        struct slot{
+            std::atomic<size_t> sequence;
+            DataType            value;
+        };
+
+        static size_t round_up_pow2(size_t n){
+            size_t p = 1;
+            while(p < n){
+                p <<= 1;
+            }
+            return p;
+        }
+
+        const size_t                      mask;
+        std::vector<slot>                 slots;
+        alignas(64) std::atomic<size_t>   enqueue_pos;
+        alignas(64) size_t                dequeue_pos;
+    };
+
+    /**
+     * @brief   a value stored as relaxed atomic words
+     * @details Lets a single writer run the ordinary heap functions on an array of
+     *          cells while readers copy individual cells concurrently (validated
+     *          by a sequence counter) without a data race.  For word-sized values
+     *          the relaxed loads and stores compile to plain moves.
+     *
+     * @tparam  DataType    the type of data stored - must be TriviallyCopyable,
+     *                      DefaultConstructable, and LessThanComparable
+     */
+    template <typename DataType>
+    class atomic_cell{
+        static_assert(std::is_trivially_copyable<DataType>::value,
+                      "atomic_cell requires a trivially copyable DataType");
+        static const size_t word_count = (sizeof(DataType) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    public:
+        atomic_cell()                                { store(DataType{}); }
+        explicit atomic_cell(const DataType& value)  { store(value);      }
+        atomic_cell(const atomic_cell& other)        { store(other.load()); }
+        atomic_cell& operator=(const atomic_cell& other){
+            store(other.load());
+            return *this;
+        }
+
+        DataType load() const {
+            uint64_t buffer[word_count];
+            for(size_t w = 0; w < word_count; ++w){
+                buffer[w] = words[w].load(std::memory_order_relaxed);
+            }
+            DataType value;
+            std::memcpy(&value, buffer, sizeof(DataType));
+            return value;
+        }
+
+        void store(const DataType& value){
+            uint64_t buffer[word_count] = {};
+            std::memcpy(buffer, &value, sizeof(DataType));
+            for(size_t w = 0; w < word_count; ++w){
+                words[w].store(buffer[w], std::memory_order_relaxed);
+            }
+        }
+
+        friend bool operator<(const atomic_cell& a, const atomic_cell& b){
+            return a.load() < b.load();
+        }
+
+    private:
+        std::atomic<uint64_t> words[word_count];
+    };
+}
+
+namespace mmheap{
+
+    /**
+     * @brief   a min-max heap whose extremes can be read without locking
+     * @details Wraps a heap array that is mutated by a single writer thread.  After
+     *          every mutation the writer publishes the current minimum and maximum
+     *          through a sequence lock, so any number of monitoring threads can call
+     *          `peek_min()`, `peek_max()`, or `peek()` concurrently without ever
+     *          blocking the writer.  Only the mutating member functions and `size()`
+     *          must be called from the writer thread.
+     *
+     *          The snapshot costs the writer one extra `heap_max()` lookup (a single
+     *          comparison) per mutation; the shared snapshot is only rewritten when
+     *          one of the extremes actually changed.
+     *
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      CopyAssignable, and TriviallyCopyable
+     */
+    template <typename DataType>
+    class published_heap{
+        static_assert(std::is_trivially_copyable<DataType>::value,
+                      "published_heap requires a trivially copyable DataType");
+    public:
+        /**
+         * @param heap_array  storage for the heap (owned by the caller)
+         * @param max_size    the physical storage allocation size of the heap
+         * @param count       number of values already in `heap_array` (they will
+         *                    be made into a heap if they aren't one already)
+         */
+        published_heap(DataType* heap_array, size_t max_size, size_t count = 0)
+            : heap_array{heap_array}, count{count}, max_size{max_size} {
+            std::memset(static_cast<void*>(&published), 0, sizeof(published));
+            mmheap::make_heap(heap_array, count);
+            publish();
+        }
+
+        void insert(const DataType& value){
+            mmheap::heap_insert(value, heap_array, count, max_size);
+            publish();
+        }
+
+        std::pair<bool, DataType> insert_circular(const DataType& value){
+            auto result = mmheap::heap_insert_circular(value, heap_array, count, max_size);
+            publish();
+            return result;
+        }
+
+        DataType remove_min(){
+            auto value = mmheap::heap_remove_min(heap_array, count);
+            publish();
+            return value;
+        }
+
+        DataType remove_max(){
+            auto value = mmheap::heap_remove_max(heap_array, count);
+            publish();
+            return value;
+        }
+
+        DataType replace_at_index(const DataType& new_value, size_t index){
+            auto value = mmheap::heap_replace_at_index(new_value, index, heap_array, count);
+            publish();
+            return value;
+        }
+
+        DataType remove_at_index(size_t index){
+            auto value = mmheap::heap_remove_at_index(index, heap_array, count);
+            publish();
+            return value;
+        }
+
+        /** number of values in the heap (writer thread only) */
+        size_t size() const { return count; }
+
+        /**
+         * read the most recently published minimum (any thread)
+         *
+         * @param[out] value  receives the minimum if the heap was non-empty
+         * @return `false` if the heap was empty at the time of publication
+         */
+        bool peek_min(DataType& value) const {
+            DataType max_value;
+            return peek(value, max_value);
+        }
+
+        /**
+         * read the most recently published maximum (any thread)
+         *
+         * @param[out] value  receives the maximum if the heap was non-empty
+         * @return `false` if the heap was empty at the time of publication
+         */
+        bool peek_max(DataType& value) const {
+            DataType min_value;
+            return peek(min_value, value);
+        }
+
+        /**
+         * read a consistent pair of the most recently published extremes (any thread)
+         *
+         * @param[out] min_value  receives the minimum if the heap was non-empty
+         * @param[out] max_value  receives the maximum if the heap was non-empty
+         * @return `false` if the heap was empty at the time of publication
+         */
+        bool peek(DataType& min_value, DataType& max_value) const {
+            snapshot s;
+            extremes.load(s);
+            if(s.non_empty){
+                min_value = s.min_value;
+                max_value = s.max_value;
+            }
+            return s.non_empty;
+        }
+
+    private:
+        struct snapshot{
+            DataType min_value;
+            DataType max_value;
+            bool     non_empty;
+        };
+
+        void publish(){
+            snapshot s;
+            std::memset(static_cast<void*>(&s), 0, sizeof(s));                          // zero padding so snapshots compare bytewise
+            s.non_empty = count > 0;
+            if(s.non_empty){
+                s.min_value = mmheap::heap_min(heap_array, count);
+                s.max_value = mmheap::heap_max(heap_array, count);
+            }
+            if(std::memcmp(&s, &published, sizeof(s)) != 0){                            // most mutations leave both extremes alone;
+                extremes.store(s);                                                      //  skipping those keeps readers' cache lines valid
+                published = s;
+            }
+        }
+
+        DataType*                         heap_array;
+        size_t                            count;
+        size_t                            max_size;
+        snapshot                          published;
+        _mmheap::seqlock_value<snapshot>  extremes;
+    };
+
+    /**
+     * @brief   a blocking double-ended priority queue for producer/consumer use
+     * @details Wraps a heap array behind a mutex.  Consumers may block waiting for
+     *          either end of the queue (`wait_pop_min()` / `wait_pop_max()`, or their
+     *          timed `_for` variants), and producers block in `push()` while the
+     *          heap is full.  Each push wakes exactly one waiting consumer: min-end
+     *          and max-end waiters wait on separate condition variables, and when
+     *          both ends have waiters the wake-ups alternate between them, so an
+     *          insert never causes a thundering herd.  Each end counts the
+     *          notifications its waiters have not yet woken up for, and a push only
+     *          notifies an end that still has a waiter beyond those, so quick
+     *          pushes never pile onto waiters that are already on their way.
+     *
+     *          `close()` wakes everyone; afterward, pops drain whatever is left and
+     *          then report failure instead of blocking.
+     *
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      and CopyAssignable
+     */
+    template <typename DataType>
+    class blocking_heap{
+    public:
+        /**
+         * @param heap_array  storage for the heap (owned by the caller)
+         * @param max_size    the physical storage allocation size of the heap
+         */
+        blocking_heap(DataType* heap_array, size_t max_size)
+            : heap_array{heap_array}, count{0}, max_size{max_size}, closed{false},
+              min_waiting{0}, max_waiting{0}, min_signals{0}, max_signals{0},
+              push_waiting{0}, wake_max_next{false} {}
+
+        blocking_heap(const blocking_heap&)            = delete;
+        blocking_heap& operator=(const blocking_heap&) = delete;
+
+        /**
+         * insert a value, blocking while the heap is full
+         *
+         * @param value  the new value to insert
+         * @throws std::runtime_error if the queue has been closed
+         */
+        void push(const DataType& value){
+            std::unique_lock<std::mutex> lock{guard};
+            ++push_waiting;
+            not_full.wait(lock, [this]{ return closed || count < max_size; });
+            --push_waiting;
+            if(closed){
+                throw std::runtime_error("Cannot insert into closed heap.");
+            }
+            mmheap::heap_insert(value, heap_array, count, max_size);
+            wake_one_consumer();
+        }
+
+        /**
+         * insert a value if there is room, without blocking
+         *
+         * @param value  the new value to insert
+         * @return `false` if the heap was full or the queue has been closed
+         */
+        bool try_push(const DataType& value){
+            std::lock_guard<std::mutex> lock{guard};
+            if(closed || count == max_size){
+                return false;
+            }
+            mmheap::heap_insert(value, heap_array, count, max_size);
+            wake_one_consumer();
+            return true;
+        }
+
+        /**
+         * remove the minimum value, blocking until one is available
+         *
+         * @param[out] value  receives the minimum value
+         * @return `false` if the queue was closed and is empty
+         */
+        bool wait_pop_min(DataType& value){
+            std::unique_lock<std::mutex> lock{guard};
+            await_value(false, [&]{ min_ready.wait(lock); return true; });
+            return pop_locked(value, false);
+        }
+
+        /**
+         * remove the maximum value, blocking until one is available
+         *
+         * @param[out] value  receives the maximum value
+         * @return `false` if the queue was closed and is empty
+         */
+        bool wait_pop_max(DataType& value){
+            std::unique_lock<std::mutex> lock{guard};
+            await_value(true, [&]{ max_ready.wait(lock); return true; });
+            return pop_locked(value, true);
+        }
+
+        /**
+         * remove the minimum value, waiting at most `timeout` for one to arrive
+         *
+         * @param[out] value    receives the minimum value
+         * @param      timeout  the longest time to wait
+         * @return `false` if the wait timed out (or the queue was closed and is empty)
+         */
+        template <typename Rep, typename Period>
+        bool wait_pop_min_for(DataType& value, const std::chrono::duration<Rep, Period>& timeout){
+            std::unique_lock<std::mutex> lock{guard};
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            await_value(false, [&]{ return min_ready.wait_until(lock, deadline) == std::cv_status::no_timeout; });
+            return pop_locked(value, false);
+        }
+
+        /**
+         * remove the maximum value, waiting at most `timeout` for one to arrive
+         *
+         * @param[out] value    receives the maximum value
+         * @param      timeout  the longest time to wait
+         * @return `false` if the wait timed out (or the queue was closed and is empty)
+         */
+        template <typename Rep, typename Period>
+        bool wait_pop_max_for(DataType& value, const std::chrono::duration<Rep, Period>& timeout){
+            std::unique_lock<std::mutex> lock{guard};
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            await_value(true, [&]{ return max_ready.wait_until(lock, deadline) == std::cv_status::no_timeout; });
+            return pop_locked(value, true);
+        }
+
+        /**
+         * remove the minimum value if one is available, without blocking
+         *
+         * @param[out] value  receives the minimum value
+         * @return `false` if the heap was empty
+         */
+        bool try_pop_min(DataType& value){
+            std::lock_guard<std::mutex> lock{guard};
+            return pop_locked(value, false);
+        }
+
+        /**
+         * remove the maximum value if one is available, without blocking
+         *
+         * @param[out] value  receives the maximum value
+         * @return `false` if the heap was empty
+         */
+        bool try_pop_max(DataType& value){
+            std::lock_guard<std::mutex> lock{guard};
+            return pop_locked(value, true);
+        }
+
+        /**
+         * remove up to `max_count` values in ascending order under a single lock
+         * acquisition, without blocking
+         *
+         * @param[out] out        array to receive the values (room for `max_count`)
+         * @param      max_count  the largest number of values to remove
+         * @return the number of values written to `out`
+         */
+        size_t drain(DataType* out, size_t max_count){
+            std::lock_guard<std::mutex> lock{guard};
+            size_t n = 0;
+            while(n < max_count && count > 0){
+                out[n++] = mmheap::heap_remove_min(heap_array, count);
+            }
+            if(n > 0 && push_waiting > 0){
+                not_full.notify_all();                                                  // several slots may have opened up
+            }
+            return n;
+        }
+
+        /**
+         * close the queue: wake all waiters, reject further pushes, and let pops
+         * drain the remaining values without blocking
+         */
+        void close(){
+            std::lock_guard<std::mutex> lock{guard};
+            closed = true;
+            min_ready.notify_all();
+            max_ready.notify_all();
+            not_full.notify_all();
+        }
+
+        /** current number of values in the queue */
+        size_t size() const {
+            std::lock_guard<std::mutex> lock{guard};
+            return count;
+        }
+
+    private:
+        bool pop_locked(DataType& value, bool from_max){
+            if(count == 0){
+                return false;
+            }
+            value = from_max ? mmheap::heap_remove_max(heap_array, count)
+                             : mmheap::heap_remove_min(heap_array, count);
+            if(push_waiting > 0){
+                not_full.notify_one();
+            }
+            return true;
+        }
+
+        /**
+         * wait (with the lock held by `wait`'s caller) until a value is available
+         * or the queue is closed
+         *
+         * @param from_max  `true` for a max-end waiter
+         * @param wait      waits on the end's condition variable once; returns
+         *                  `false` if the wait timed out
+         */
+        template <typename Wait>
+        void await_value(bool from_max, Wait wait){
+            auto& waiting = from_max ? max_waiting : min_waiting;
+            auto& signals = from_max ? max_signals : min_signals;
+            ++waiting;
+            while(!closed && count == 0){
+                bool timed_out = !wait();
+                if(signals > 0){                                                        // every wake-up absorbs one notification, so a
+                    --signals;                                                          //  waiter that sleeps again counts as un-notified
+                }
+                if(timed_out){
+                    break;
+                }
+            }
+            --waiting;
+        }
+
+        void wake_one_consumer(){
+            bool min_asleep = min_waiting > min_signals;                                // waiters not yet notified at each end
+            bool max_asleep = max_waiting > max_signals;
+            bool wake_max   = max_asleep && (!min_asleep || wake_max_next);
+            if(wake_max){
+                ++max_signals;
+                max_ready.notify_one();
+            }
+            else if(min_asleep){
+                ++min_signals;
+                min_ready.notify_one();
+            }
+            wake_max_next = !wake_max;                                                  // alternate when both ends are waiting
+        }
+
+        DataType*                heap_array;
+        size_t                   count;
+        size_t                   max_size;
+        bool                     closed;
+        size_t                   min_waiting;
+        size_t                   max_waiting;
+        size_t                   min_signals;                                           // notifications not yet absorbed by a wake-up
+        size_t                   max_signals;
+        size_t                   push_waiting;
+        bool                     wake_max_next;
+        mutable std::mutex       guard;
+        std::condition_variable  min_ready;
+        std::condition_variable  max_ready;
+        std::condition_variable  not_full;
+    };
+
+    /**
+     * @brief   a heap owned by one thread, fed by any number of producer threads
+     * @details Producers hand values to a lock-free ring buffer and never touch the
+     *          heap (or any lock).  The owner thread moves everything pending into
+     *          the heap with a single batch repair (see `heap_insert_batch()`) before
+     *          each read or removal, so the heap itself needs no synchronization.
+     *          Only `push()` and `try_push()` may be called from producer threads;
+     *          every other member function belongs to the owner.
+     *
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      DefaultConstructable, LessThanComparable, Swappable,
+     *                      CopyConstructable, and CopyAssignable
+     */
+    template <typename DataType>
+    class ingest_heap{
+    public:
+        /**
+         * @param heap_array     storage for the heap (owned by the caller)
+         * @param max_size       the physical storage allocation size of the heap
+         * @param ring_capacity  the number of values producers may have pending
+         *                       before `try_push()` starts to fail
+         */
+        ingest_heap(DataType* heap_array, size_t max_size, size_t ring_capacity = 4096)
+            : heap_array{heap_array}, count{0}, max_size{max_size}, pending{ring_capacity} {}
+
+        ingest_heap(const ingest_heap&)            = delete;
+        ingest_heap& operator=(const ingest_heap&) = delete;
+
+        /**
+         * hand a value to the owner (any thread)
+         *
+         * @param value  the new value to insert
+         * @return `false` if too many values are already pending
+         */
+        bool try_push(const DataType& value){
+            return pending.try_push(value);
+        }
+
+        /**
+         * hand a value to the owner, yielding while too many values are pending (any thread)
+         *
+         * @param value  the new value to insert
+         */
+        void push(const DataType& value){
+            while(!pending.try_push(value)){
+                std::this_thread::yield();
+            }
+        }
+
+        /**
+         * move all pending values into the heap (as many as it has room for)
+         *
+         * @return the number of values moved
+         */
+        size_t flush(){
+            size_t moved = pending.pop_batch(heap_array + count, max_size - count);     // written in place, past the end of the heap
+            if(moved > 0){
+                _mmheap::repair_range(heap_array, count, count + moved - 1, count + moved - 1);
+                count += moved;
+            }
+            return moved;
+        }
+
+        DataType min(){
+            flush();
+            return mmheap::heap_min(heap_array, count);
+        }
+
+        DataType max(){
+            flush();
+            return mmheap::heap_max(heap_array, count);
+        }
+
+        DataType remove_min(){
+            flush();
+            return mmheap::heap_remove_min(heap_array, count);
+        }
+
+        DataType remove_max(){
+            flush();
+            return mmheap::heap_remove_max(heap_array, count);
+        }
+
+        /** number of values in the heap, after moving pending values in */
+        size_t size(){
+            flush();
+            return count;
+        }
+
+    private:
+        DataType*                     heap_array;
+        size_t                        count;
+        size_t                        max_size;
+        _mmheap::mpsc_ring<DataType>  pending;
+    };
+
+    /**
+     * @brief   per-thread bounded heaps with a lock-free global top-k / bottom-k merge
+     * @details Each shard is a bounded heap filled with `heap_insert_circular()` by
+     *          the one thread that owns it, so it retains the `shard_capacity`
+     *          smallest values that thread has seen.  Any thread may ask for the
+     *          `k` smallest (`bottom_k()`) or largest (`top_k()`) values across all
+     *          shards without blocking the writers.
+     *
+     *          The merge walks the implicit trees of all shards at once with a small
+     *          frontier heap: it starts from each shard's extreme (`heap_min()` or
+     *          `heap_max()` position) and only ever expands the children and
+     *          grandchildren of a value that has been emitted, so it reads
+     *          O(P + k) cells and costs O((P + k) log(P + k)) regardless of how full
+     *          the shards are.  Each shard is guarded by a sequence counter; the
+     *          merge is retried if a writer touched a shard during the walk, and
+     *          falls back to copying the shards one at a time if that keeps happening.
+     *          A copy that a writer disturbs raises the shard's "reader pending"
+     *          count, and the writer yields before its next insert until the copy is
+     *          done, so `bottom_k()` and `top_k()` always finish: each shard costs at
+     *          most one disturbed copy plus the insert already in progress.  Writers
+     *          never block otherwise, and a writer only waits for readers that have
+     *          already failed once on its shard.
+     *
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      DefaultConstructable, LessThanComparable, Swappable,
+     *                      CopyConstructable, CopyAssignable, and TriviallyCopyable
+     */
+    template <typename DataType>
+    class sharded_heap{
+        typedef _mmheap::atomic_cell<DataType> cell;
+    public:
+        /**
+         * @param shard_count     number of shards (usually one per writer thread)
+         * @param shard_capacity  number of values each shard retains
+         */
+        sharded_heap(size_t shard_count, size_t shard_capacity){
+            if(shard_capacity == 0){
+                throw std::runtime_error("Cannot create sharded heap with zero-capacity shards.");
+            }
+            for(size_t i = 0; i < shard_count; ++i){
+                shards.emplace_back(new shard(shard_capacity));
+            }
+        }
+
+        /**
+         * @brief   add to a shard, rotating its maximum value out if it is full
+         * @details Must only be called by the thread that owns `shard_index`.
+         *
+         * @param shard_index  the shard to insert into
+         * @param value        new value to add
+         * @return the same flag and rotated-out value as `heap_insert_circular()`
+         */
+        std::pair<bool, DataType> insert(size_t shard_index, const DataType& value){
+            auto& s   = *shards.at(shard_index);
+            while(s.readers_pending.load() > 0){                                        // let a disturbed copy finish (see `copy_shard()`)
+                std::this_thread::yield();
+            }
+            auto  seq = s.sequence.load(std::memory_order_relaxed);
+            s.sequence.store(seq + 1, std::memory_order_relaxed);                       // odd: shard is changing
+            std::atomic_thread_fence(std::memory_order_release);
+            auto result = mmheap::heap_insert_circular(cell{value}, s.cells.data(), s.count, s.cells.size());
+            s.published_count.store(s.count, std::memory_order_relaxed);
+            s.sequence.store(seq + 2, std::memory_order_release);
+            return std::pair<bool, DataType>{result.first, result.second.load()};
+        }
+
+        size_t shard_count() const { return shards.size(); }
+
+        /**
+         * get the `k` smallest values across all shards (any thread)
+         *
+         * @param[out] out  array to receive the values in ascending order (room for `k`)
+         * @param      k    the number of values wanted
+         * @return the number of values written (less than `k` if the shards hold fewer)
+         */
+        size_t bottom_k(DataType* out, size_t k) const {
+            return merge(out, k, false);
+        }
+
+        /**
+         * get the `k` largest values across all shards (any thread)
+         *
+         * @param[out] out  array to receive the values in descending order (room for `k`)
+         * @param      k    the number of values wanted
+         * @return the number of values written (less than `k` if the shards hold fewer)
+         */
+        size_t top_k(DataType* out, size_t k) const {
+            return merge(out, k, true);
+        }
+
+    private:
+        struct shard{
+            explicit shard(size_t capacity) : sequence{0}, readers_pending{0}, published_count{0}, count{0}, cells(capacity) {}
+            std::atomic<uint64_t>  sequence;
+            std::atomic<unsigned>  readers_pending;                                     // copies the writer must not disturb again
+            std::atomic<size_t>    published_count;
+            size_t                 count;
+            std::vector<cell>      cells;
+            char                   padding[64];                                        // keep neighboring shards off this cache line
+        };
+
+        struct candidate{
+            DataType value;
+            size_t   shard_index;
+            size_t   index;
+        };
+
+        static const int optimistic_attempts = 4;
+
+        size_t merge(DataType* out, size_t k, bool largest) const {
+            std::vector<uint64_t> seen(shards.size());
+            std::vector<size_t>   counts(shards.size());
+            for(int attempt = 0; attempt < optimistic_attempts; ++attempt){
+                for(size_t i = 0; i < shards.size(); ++i){
+                    seen[i]   = stable_sequence(*shards[i]);
+                    counts[i] = shards[i]->published_count.load(std::memory_order_relaxed);
+                }
+                auto n = walk(out, k, largest, counts, [this](size_t s, size_t i){ return shards[s]->cells[i].load(); });
+                std::atomic_thread_fence(std::memory_order_acquire);
+                bool valid = true;
+                for(size_t i = 0; valid && i < shards.size(); ++i){
+                    valid = shards[i]->sequence.load(std::memory_order_relaxed) == seen[i];
+                }
+                if(valid){
+                    return n;
+                }
+            }
+            std::vector<std::vector<DataType>> copies(shards.size());                   // writers keep interfering: copy one shard at a time
+            for(size_t i = 0; i < shards.size(); ++i){
+                copy_shard(*shards[i], copies[i]);
+                counts[i] = copies[i].size();
+            }
+            return walk(out, k, largest, counts, [&copies](size_t s, size_t i){ return copies[s][i]; });
+        }
+
+        template <typename ReadCell>
+        static size_t walk(DataType* out, size_t k, bool largest, const std::vector<size_t>& counts, ReadCell read){
+            auto before = [largest](const candidate& a, const candidate& b){            // frontier top is the next value to emit
+                return largest ? a.value < b.value : b.value < a.value;
+            };
+            std::vector<candidate> frontier;
+            auto push = [&](size_t s, size_t i){
+                if(i < counts[s]){
+                    frontier.push_back(candidate{read(s, i), s, i});
+                    std::push_heap(frontier.begin(), frontier.end(), before);
+                }
+            };
+            for(size_t s = 0; s < counts.size(); ++s){
+                _mmheap::sorted_walk_start(largest, [&](size_t i){ push(s, i); });
+            }
+            size_t n = 0;
+            while(n < k && !frontier.empty()){
+                std::pop_heap(frontier.begin(), frontier.end(), before);
+                auto next = frontier.back();
+                frontier.pop_back();
+                out[n++] = next.value;
+                _mmheap::sorted_walk_expand(next.index, largest, [&](size_t i){ push(next.shard_index, i); });
+            }
+            return n;
+        }
+
+        static uint64_t stable_sequence(const shard& s){
+            auto seq = s.sequence.load(std::memory_order_acquire);
+            while(seq & 1){
+                std::this_thread::yield();
+                seq = s.sequence.load(std::memory_order_acquire);
+            }
+            return seq;
+        }
+
+        static void copy_shard(shard& s, std::vector<DataType>& copy){
+            copy.reserve(s.cells.size());                                               // nothing below may throw once the writer is held up
+            if(try_copy_shard(s, copy)){
+                return;
+            }
+            s.readers_pending.fetch_add(1);                                             // the writer yields until this copy succeeds
+            while(!try_copy_shard(s, copy)){}                                           // only an insert already in progress can still interfere
+            s.readers_pending.fetch_sub(1);
+        }
+
+        static bool try_copy_shard(const shard& s, std::vector<DataType>& copy){
+            auto seq   = stable_sequence(s);
+            auto count = s.published_count.load(std::memory_order_relaxed);
+            copy.resize(count);
+            for(size_t i = 0; i < count; ++i){
+                copy[i] = s.cells[i].load();
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return s.sequence.load(std::memory_order_relaxed) == seq;
+        }
+
+        std::vector<std::unique_ptr<shard>> shards;
+    };
+
+    /**
+     * @brief   a description of the machine's NUMA nodes
+     * @details `detect()` reads the online nodes and their CPUs from Linux sysfs
+     *          (and reports a single node elsewhere, or if sysfs is unavailable);
+     *          nodes are numbered densely from 0 even when the kernel's node IDs
+     *          have gaps.  `simulated()`
+     *          reports an arbitrary number of nodes and lets each thread choose
+     *          which one it is "on" with `simulate_current_node()`, so NUMA-aware
+     *          code can be exercised on a single-node machine.
+     */
+    class numa_topology{
+    public:
+        static numa_topology detect(){
+            numa_topology topology{1, false};
+#if defined(__linux__)
+            std::ifstream online("/sys/devices/system/node/online");                  // node IDs may be sparse, e.g. "0,2"
+            std::string   node_ids;
+            if(std::getline(online, node_ids)){
+                size_t node = 0;                                                        // dense index of each online node
+                for_each_in_ranges(node_ids, [&](size_t id){
+                    std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+                    std::string   cpus;
+                    std::getline(cpulist, cpus);
+                    for_each_in_ranges(cpus, [&](size_t cpu){
+                        if(topology.cpu_to_node.size() <= cpu){
+                            topology.cpu_to_node.resize(cpu + 1, 0);
+                        }
+                        topology.cpu_to_node[cpu] = node;
+                    });
+                    ++node;
+                });
+                topology.nodes = std::max<size_t>(node, 1);
+            }
+#endif
+            return topology;
+        }
+
+        static numa_topology simulated(size_t node_count){
+            return numa_topology{std::max<size_t>(node_count, 1), true};
+        }
+
+        /** choose the node the calling thread is "on" for simulated topologies */
+        static void simulate_current_node(size_t node){
+            simulated_node() = node;
+        }
+
+        size_t node_count() const { return nodes; }
+
+        /** the node the calling thread is currently running on */
+        size_t current_node() const {
+            if(simulate){
+                return simulated_node() % nodes;
+            }
+#if defined(__linux__)
+            auto cpu = sched_getcpu();
+            if(cpu >= 0 && static_cast<size_t>(cpu) < cpu_to_node.size()){
+                return cpu_to_node[cpu];
+            }
+#endif
+            return 0;
+        }
+
+    private:
+        numa_topology(size_t nodes, bool simulate) : nodes{nodes}, simulate{simulate} {}
+
+        static size_t& simulated_node(){
+            static thread_local size_t node = 0;
+            return node;
+        }
+
+        template <typename Visit>
+        static void for_each_in_ranges(const std::string& ranges, Visit visit){
+            size_t pos = 0;
+            while(pos < ranges.size() && std::isdigit(static_cast<unsigned char>(ranges[pos]))){  // "0-3,8-11"
+                size_t end   = 0;
+                size_t first = std::stoul(ranges.substr(pos), &end);
+                size_t last  = first;
+                pos += end;
+                if(pos < ranges.size() && ranges[pos] == '-'){
+                    last = std::stoul(ranges.substr(pos + 1), &end);
+                    pos += end + 1;
+                }
+                for(size_t n = first; n <= last; ++n){
+                    visit(n);
+                }
+                if(pos < ranges.size() && ranges[pos] == ','){
+                    ++pos;
+                }
+            }
+        }
+
+        size_t               nodes;
+        bool                 simulate;
+        std::vector<size_t>  cpu_to_node;
+    };
+
+    /**
+     * @brief   a double-ended priority queue sharded across NUMA nodes
+     * @details Keeps one min-max heap per NUMA node.  Threads push into the heap of
+     *          the node they are running on, and pop from it too unless another
+     *          node's extreme is better than the local one by more than
+     *          `steal_margin` (or the local heap is empty).  Each shard publishes its
+     *          extremes like a `published_heap`, so choosing a shard reads remote
+     *          memory only for those two values; the heap array itself is touched
+     *          remotely only when a steal actually happens.  A push that finds the
+     *          local heap full spills to the least-loaded remote heap instead, so
+     *          the queue as a whole holds up to `node_count() * shard_capacity`
+     *          values no matter which nodes the pushing threads run on.
+     *
+     *          Shard storage is allocated up front, but for trivially constructible
+     *          types its pages are not touched until values are first written
+     *          there.  Under the usual first-touch policy the kernel places each
+     *          page on the node of the thread that writes it first, so a shard ends
+     *          up in its own node's memory only as far as its own node's threads
+     *          fill it first.  A spill breaks this: it writes into the least-loaded
+     *          remote shard, which is usually the one with the most untouched
+     *          pages, and every page it touches first stays on the spilling
+     *          thread's node for the life of the heap.  From then on that shard's
+     *          owners pay remote accesses on those pages, on top of the lock and
+     *          cache traffic of the spill itself.  Size `shard_capacity` so that
+     *          spills are rare, or fill the queue from every node once before
+     *          relying on placement.
+     *
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      DefaultConstructable, LessThanComparable, Swappable,
+     *                      CopyConstructable, CopyAssignable, TriviallyCopyable,
+     *                      and Addable (for the steal margin)
+     */
+    template <typename DataType>
+    class numa_heap{
+    public:
+        /**
+         * @param topology        the machine (or simulated) topology
+         * @param shard_capacity  the physical storage allocation size of each node's heap
+         * @param steal_margin    how much better a remote extreme must be before
+         *                        it is taken instead of the local one
+         */
+        numa_heap(const numa_topology& topology, size_t shard_capacity, const DataType& steal_margin = DataType{})
+            : topology{topology}, steal_margin{steal_margin}, shard_capacity{shard_capacity} {
+            for(size_t node = 0; node < topology.node_count(); ++node){
+                shards.emplace_back(new shard(shard_capacity));
+            }
+        }
+
+        /**
+         * insert a value into the calling thread's local heap, or into the
+         * least-loaded remote heap if the local one is full
+         *
+         * @param value  the new value to insert
+         * @throws std::runtime_error if every heap is full
+         */
+        void push(const DataType& value){
+            auto local = topology.current_node();
+            if(try_insert(*shards[local], value)){
+                return;
+            }
+            for(;;){                                                                    // another thread may fill the chosen shard first
+                size_t target = shards.size();
+                size_t lowest = shard_capacity;
+                for(size_t node = 0; node < shards.size(); ++node){
+                    if(node != local){
+                        std::lock_guard<std::mutex> lock{shards[node]->guard};
+                        if(shards[node]->heap.size() < lowest){
+                            lowest = shards[node]->heap.size();
+                            target = node;
+                        }
+                    }
+                }
+                if(target == shards.size()){
+                    throw std::runtime_error("Cannot insert into heap - allocated size is full.");
+                }
+                if(try_insert(*shards[target], value)){
+                    return;
+                }
+            }
+        }
+
+        /**
+         * remove the minimum value, preferring the calling thread's local heap
+         *
+         * @param[out] value  receives the value removed
+         * @return `false` if every heap was empty
+         */
+        bool try_pop_min(DataType& value){
+            return pop(value, false);
+        }
+
+        /**
+         * remove the maximum value, preferring the calling thread's local heap
+         *
+         * @param[out] value  receives the value removed
+         * @return `false` if every heap was empty
+         */
+        bool try_pop_max(DataType& value){
+            return pop(value, true);
+        }
+
+        size_t node_count() const { return shards.size(); }
+
+    private:
+        struct shard{
+            explicit shard(size_t capacity) : storage{new DataType[capacity]}, heap{storage.get(), capacity} {}
+            std::mutex                  guard;
+            std::unique_ptr<DataType[]> storage;
+            published_heap<DataType>    heap;
+            char                        padding[64];                                    // keep neighboring shards off this cache line
+        };
+
+        bool try_insert(shard& target, const DataType& value){
+            std::lock_guard<std::mutex> lock{target.guard};
+            if(target.heap.size() == shard_capacity){
+                return false;
+            }
+            target.heap.insert(value);
+            return true;
+        }
+
+        bool pop(DataType& value, bool from_max){
+            auto local    = topology.current_node();
+            bool any_left = true;
+            while(any_left){
+                any_left         = false;
+                size_t target    = local;
+                bool   have_best = false;
+                DataType best;
+                for(size_t node = 0; node < shards.size(); ++node){                     // local shard first, then remote shards
+                    auto candidate = (local + node) % shards.size();
+                    DataType min_value, max_value;
+                    if(shards[candidate]->heap.peek(min_value, max_value)){
+                        any_left     = true;
+                        auto extreme = from_max ? max_value : min_value;
+                        if(!have_best || better(extreme, best, from_max, candidate != local && target == local)){
+                            target    = candidate;
+                            best      = extreme;
+                            have_best = true;
+                        }
+                    }
+                }
+                if(have_best){
+                    auto& chosen = *shards[target];
+                    std::lock_guard<std::mutex> lock{chosen.guard};
+                    if(chosen.heap.size() > 0){                                         // it may have emptied since it was peeked
+                        value = from_max ? chosen.heap.remove_max() : chosen.heap.remove_min();
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        bool better(const DataType& remote, const DataType& current, bool from_max, bool current_is_local) const {
+            if(current_is_local){                                                       // leaving the local node must be worth the margin
+                return from_max ? current + steal_margin < remote : remote + steal_margin < current;
+            }
+            return from_max ? current < remote : remote < current;
+        }
+
+        numa_topology                       topology;
+        DataType                            steal_margin;
+        size_t                              shard_capacity;
+        std::vector<std::unique_ptr<shard>> shards;
+    };
+}
+
+#endif
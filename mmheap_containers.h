@@ -0,0 +1,774 @@
+#ifndef MMHEAP_CONTAINERS_H
+#define MMHEAP_CONTAINERS_H
+/**
+ * @file mmheap_containers.h
+ *
+ * Defines container types built on a Min-Max Heap (see `mmheap.h`).
+ *
+ * @details
+ *   The functions in `mmheap.h` keep a single flat heap array up to date one
+ *   operation at a time.  The types in this file wrap that array with extra
+ *   bookkeeping for workloads the plain functions handle poorly, such as heavy
+ *   cancellation or heaps far larger than the processor's caches.
+ *
+ *   When compiled as C++17 or later with `<memory_resource>` available,
+ *   `MMHEAP_HAS_PMR` is defined and `mmheap::pmr::vector_heap` is provided.
+ *
+ * @license   Released under the MIT License: http://opensource.org/licenses/MIT
+ * @copyright Copyright (c) 2015 Jason L Causey, Arkansas State University
+ */
+
+#include "mmheap.h"
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<memory_resource>) && __cplusplus >= 201703L
+#include <memory_resource>
+#define MMHEAP_HAS_PMR 1
+#endif
+#endif
+
+namespace mmheap{
+
+    /**
+     * @brief   a growable min-max heap that owns its storage through an allocator
+     * @details The heap array is a `std::vector<DataType, Allocator>`, so the heap
+     *          allocates however the allocator says.  With
+     *          `std::pmr::polymorphic_allocator` (see `mmheap::pmr::vector_heap`)
+     *          a request-scoped heap can draw its array from a
+     *          `std::pmr::monotonic_buffer_resource` and release everything at once
+     *          with the resource.  Because the vector constructs its values through
+     *          the allocator, allocator-aware values such as `std::pmr::string`
+     *          are given the same resource, and the heap's sift swaps never mix
+     *          two resources.
+     *
+     *          The operations are the `_mmheap` primitives run on `data()`, with the
+     *          same results as the corresponding `mmheap` functions.
+     *
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, MoveConstructible,
+     *                      and MoveAssignable
+     * @tparam  Allocator   an allocator for `DataType`
+     */
+    template <typename DataType, typename Allocator = std::allocator<DataType>>
+    class vector_heap{
+    public:
+        typedef Allocator allocator_type;
+
+        vector_heap() = default;
+
+        explicit vector_heap(const Allocator& allocator) : values(allocator) {}
+
+        vector_heap(const vector_heap& other, const Allocator& allocator) : values(other.values, allocator) {}
+        vector_heap(vector_heap&& other, const Allocator& allocator) : values(std::move(other.values), allocator) {}
+
+        /** insert a new value */
+        void insert(const DataType& value){
+            values.push_back(value);
+            _mmheap::bubble_up(values.data(), values.size() - 1);
+        }
+
+        /** insert a new value */
+        void insert(DataType&& value){
+            values.push_back(std::move(value));
+            _mmheap::bubble_up(values.data(), values.size() - 1);
+        }
+
+        /** insert a new value constructed in place from `args` */
+        template <typename... Args>
+        void emplace(Args&&... args){
+            values.emplace_back(std::forward<Args>(args)...);
+            _mmheap::bubble_up(values.data(), values.size() - 1);
+        }
+
+        /**
+         * @return the minimum value in the heap
+         * @throws std::runtime_error if the heap is empty
+         */
+        const DataType& min() const {
+            if(values.empty()){
+                throw std::runtime_error("Cannot get min value in empty heap.");
+            }
+            return values[0];
+        }
+
+        /**
+         * @return the maximum value in the heap
+         * @throws std::runtime_error if the heap is empty
+         */
+        const DataType& max() const {
+            if(values.empty()){
+                throw std::runtime_error("Cannot get max value in empty heap.");
+            }
+            return values[max_index()];
+        }
+
+        /**
+         * remove and return the minimum value in the heap
+         *
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType remove_min(){
+            if(values.empty()){
+                throw std::runtime_error("Cannot remove from empty heap.");
+            }
+            return remove_at(0);
+        }
+
+        /**
+         * remove and return the maximum value in the heap
+         *
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType remove_max(){
+            if(values.empty()){
+                throw std::runtime_error("Cannot remove from empty heap.");
+            }
+            return remove_at(max_index());
+        }
+
+        void clear()                { values.clear();      }
+        void reserve(size_t n)      { values.reserve(n);   }
+
+        size_t          size()          const { return values.size();          }
+        bool            empty()         const { return values.empty();         }
+        size_t          capacity()      const { return values.capacity();      }
+        const DataType* data()          const { return values.data();          }
+        allocator_type  get_allocator() const { return values.get_allocator(); }
+
+    private:
+        size_t max_index() const {
+            auto m = _mmheap::max_child(values.data(), 0, values.size()-1);
+            return m.first ? m.second : 0;
+        }
+
+        DataType remove_at(size_t index){
+            DataType value = std::move(values[index]);
+            if(index + 1 < values.size()){
+                values[index] = std::move(values.back());
+                values.pop_back();
+                _mmheap::repair_at(values.data(), index, value, values.size()-1);
+            }
+            else{
+                values.pop_back();
+            }
+            return value;
+        }
+
+        std::vector<DataType, Allocator>  values;
+    };
+
+    /**
+     * @brief   a min-max heap with O(1) lazy deletion
+     * @details Values are deleted by flagging them rather than by finding and
+     *          removing them: the value itself must be able to report that it has
+     *          been deleted (for instance a pointer or handle to a timer that
+     *          carries a "cancelled" flag), as judged by `IsDead`.  After flagging a
+     *          value, call `add_tombstones()` exactly once for it so the heap knows
+     *          how many dead values it is carrying.  Heap operations may run in
+     *          between: a flagged value that is discarded before it is counted is
+     *          remembered, and the later `add_tombstones()` settles it instead of
+     *          counting a tombstone that is already gone.
+     *
+     *          Dead values are left in place until they surface: `min()`, `max()`,
+     *          `remove_min()`, and `remove_max()` discard any dead values at that end
+     *          of the heap before answering.  Once dead values make up more than
+     *          `max_dead_fraction` of the stored values, `add_tombstones()` purges
+     *          them all with a single `heap_remove_if()` pass, so the purge costs
+     *          amortized O(1) per deletion and the array never fills with garbage.
+     *          A value must never come back to life once `IsDead` reports it dead.
+     *
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      and CopyAssignable
+     * @tparam  IsDead      a predicate called as `is_dead(value)`; `true` marks a tombstone
+     */
+    template <typename DataType, typename IsDead>
+    class tombstone_heap{
+    public:
+        /**
+         * @param heap_array        storage for the heap (owned by the caller)
+         * @param max_size          the physical storage allocation size of the heap
+         * @param is_dead           the tombstone predicate
+         * @param max_dead_fraction purge once more than this fraction of the stored
+         *                          values are tombstones
+         */
+        tombstone_heap(DataType* heap_array, size_t max_size, IsDead is_dead = IsDead{}, double max_dead_fraction = 0.5)
+            : heap_array{heap_array}, count{0}, max_size{max_size}, dead{0}, uncounted{0},
+              is_dead(is_dead), max_dead_fraction{max_dead_fraction} {}
+
+        /**
+         * insert a new value (purging tombstones first if the array is full)
+         *
+         * @throws std::runtime_error if the heap is full of live values
+         */
+        void insert(const DataType& value){
+            if(count == max_size && dead > 0){
+                compact();
+            }
+            heap_insert(value, heap_array, count, max_size);
+        }
+
+        /**
+         * record that `n` more stored values have been flagged dead, purging every
+         * tombstone if they now exceed the allowed fraction of the heap
+         */
+        void add_tombstones(size_t n = 1){
+            auto settled = std::min(n, uncounted);                                      // already discarded before being counted
+            uncounted -= settled;
+            dead = std::min(dead + (n - settled), count);
+            if(dead > 0 && dead > max_dead_fraction * count){
+                compact();
+            }
+        }
+
+        /**
+         * @return the smallest live value
+         * @throws std::runtime_error if the heap holds no live values
+         */
+        DataType min(){
+            surface_min();
+            return heap_min(heap_array, count);
+        }
+
+        /**
+         * @return the largest live value
+         * @throws std::runtime_error if the heap holds no live values
+         */
+        DataType max(){
+            surface_max();
+            return heap_max(heap_array, count);
+        }
+
+        /**
+         * remove and return the smallest live value
+         *
+         * @throws std::runtime_error if the heap holds no live values
+         */
+        DataType remove_min(){
+            surface_min();
+            return heap_remove_min(heap_array, count);
+        }
+
+        /**
+         * remove and return the largest live value
+         *
+         * @throws std::runtime_error if the heap holds no live values
+         */
+        DataType remove_max(){
+            surface_max();
+            return heap_remove_max(heap_array, count);
+        }
+
+        /** remove every tombstone now, repairing the heap once */
+        void compact(){
+            auto removed = heap_remove_if(is_dead, heap_array, count);
+            uncounted += removed - std::min(removed, dead);                             // flagged, but add_tombstones() not called yet
+            dead = 0;
+        }
+
+        /** number of live values in the heap */
+        size_t size() const { return count - dead; }
+
+        /** `true` if the heap holds no live values */
+        bool empty() const { return size() == 0; }
+
+        /** number of values stored in the array, live or dead */
+        size_t stored() const { return count; }
+
+        /** number of tombstones still stored in the array */
+        size_t tombstones() const { return dead; }
+
+    private:
+        void discard_one(){
+            if(dead > 0){
+                --dead;
+            }
+            else{
+                ++uncounted;
+            }
+        }
+
+        void surface_min(){
+            while(count > 0 && is_dead(heap_array[0])){
+                heap_remove_min(heap_array, count);
+                discard_one();
+            }
+        }
+
+        void surface_max(){
+            while(count > 0){
+                auto m = _mmheap::max_child(heap_array, 0, count-1);
+                auto i = m.first ? m.second : 0;
+                if(!is_dead(heap_array[i])){
+                    break;
+                }
+                heap_remove_at_index(i, heap_array, count);
+                discard_one();
+            }
+        }
+
+        DataType* heap_array;
+        size_t    count;
+        size_t    max_size;
+        size_t    dead;
+        size_t    uncounted;                                                            // tombstones discarded before add_tombstones() counted them
+        IsDead    is_dead;
+        double    max_dead_fraction;
+    };
+
+    /**
+     * @brief   a double-ended priority queue of many small heaps, for huge queues
+     * @details A flat heap of a billion values spans about 30 levels, nearly all of
+     *          them cold in cache, and every insert or removal walks a path through
+     *          them.  This structure instead keeps the values in bounded "leaf"
+     *          min-max heaps of at most `leaf_capacity` values each (sized to stay in
+     *          L2), with the leaves partitioned by key range: every value in a leaf is
+     *          no larger than any value in the next leaf.
+     *
+     *          The top level is the small, cache-resident sorted array of each leaf's
+     *          lower bound.  Because of the partitioning the minimum is always in the
+     *          first leaf and the maximum in the last, so `min()`, `max()`,
+     *          `remove_min()`, and `remove_max()` only ever touch the two end leaves,
+     *          which stay hot in cache; an insert binary-searches the bounds and then
+     *          does an ordinary `heap_insert()` into one leaf (whose bubble-up
+     *          usually stops within a level or two).
+     *
+     *          A full leaf is split around its median (with `std::nth_element()` and
+     *          two `make_heap()` calls - amortized O(1) per insert), and a leaf that
+     *          falls below a quarter full is merged with its neighbor when the two
+     *          fit in one leaf.
+     *
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      CopyAssignable, and DefaultConstructible
+     */
+    template <typename DataType>
+    class two_level_heap{
+    public:
+        /**
+         * @param leaf_capacity  values per leaf heap (0 picks about 256 KiB of
+         *                       values; at least 4)
+         */
+        explicit two_level_heap(size_t leaf_capacity = 0)
+            : leaf_capacity{std::max<size_t>(4, leaf_capacity ? leaf_capacity : (256 * 1024) / sizeof(DataType))},
+              value_count{0} {
+            order.push_back(new_leaf());
+            lows.push_back(DataType{});                                                 // the first leaf has no lower bound
+        }
+
+        void insert(const DataType& value){
+            auto pos = route(value);
+            if(leaves[order[pos]]->count == leaf_capacity){
+                split(pos);
+                pos = route(value);
+            }
+            auto& l = *leaves[order[pos]];
+            heap_insert(value, l.values.data(), l.count, leaf_capacity);
+            ++value_count;
+        }
+
+        /**
+         * @return the minimum value
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType min() const {
+            auto& l = *leaves[order.front()];
+            return heap_min(l.values.data(), l.count);
+        }
+
+        /**
+         * @return the maximum value
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType max() const {
+            auto& l = *leaves[order.back()];
+            return heap_max(l.values.data(), l.count);
+        }
+
+        /**
+         * remove and return the minimum value
+         *
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType remove_min(){
+            auto& l     = *leaves[order.front()];
+            auto  value = heap_remove_min(l.values.data(), l.count);
+            --value_count;
+            shrank(0);
+            return value;
+        }
+
+        /**
+         * remove and return the maximum value
+         *
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType remove_max(){
+            auto& l     = *leaves[order.back()];
+            auto  value = heap_remove_max(l.values.data(), l.count);
+            --value_count;
+            shrank(order.size() - 1);
+            return value;
+        }
+
+        size_t size()       const { return value_count;      }
+        bool   empty()      const { return value_count == 0; }
+        size_t leaf_count() const { return order.size();     }
+
+    private:
+        struct leaf{
+            explicit leaf(size_t capacity) : values(capacity), count{0} {}
+            std::vector<DataType> values;
+            size_t                count;
+        };
+
+        size_t new_leaf(){
+            if(!free_leaves.empty()){
+                auto id = free_leaves.back();
+                free_leaves.pop_back();
+                return id;
+            }
+            leaves.emplace_back(new leaf{leaf_capacity});
+            return leaves.size() - 1;
+        }
+
+        size_t route(const DataType& value) const {                                     // position of the leaf whose range holds `value`
+            return std::upper_bound(lows.begin() + 1, lows.end(), value) - lows.begin() - 1;
+        }
+
+        void split(size_t pos){                                                         // split a full leaf around its median
+            auto& l     = *leaves[order[pos]];
+            auto  id    = new_leaf();
+            auto& upper = *leaves[id];
+            auto  half  = l.count / 2;
+            std::nth_element(l.values.begin(), l.values.begin() + half, l.values.begin() + l.count);
+            std::copy(l.values.begin() + half, l.values.begin() + l.count, upper.values.begin());
+            upper.count = l.count - half;
+            l.count     = half;
+            make_heap(l.values.data(), l.count);
+            make_heap(upper.values.data(), upper.count);
+            order.insert(order.begin() + pos + 1, id);
+            lows.insert(lows.begin() + pos + 1, heap_min(upper.values.data(), upper.count));
+        }
+
+        void shrank(size_t pos){                                                        // bookkeeping after the leaf at `pos` lost a value
+            if(order.size() < 2 || leaves[order[pos]]->count >= leaf_capacity / 4){
+                return;
+            }
+            auto  lower_pos = pos + 1 < order.size() ? pos : pos - 1;                   // merge with a neighbor if the two fit in one leaf
+            auto& lower     = *leaves[order[lower_pos]];
+            auto& upper     = *leaves[order[lower_pos + 1]];
+            if(lower.count + upper.count <= leaf_capacity){
+                heap_insert_batch(upper.values.data(), upper.count, lower.values.data(), lower.count, leaf_capacity);
+                upper.count = 0;
+                free_leaves.push_back(order[lower_pos + 1]);
+                order.erase(order.begin() + lower_pos + 1);
+                lows.erase(lows.begin() + lower_pos + 1);
+            }
+        }
+
+        size_t                              leaf_capacity;
+        std::vector<std::unique_ptr<leaf>>  leaves;
+        std::vector<size_t>                 order;                                      // leaf ids in key order
+        std::vector<DataType>               lows;                                       // lower bound of each leaf in `order` (`lows[0]` unused)
+        std::vector<size_t>                 free_leaves;                                // merged-away leaves whose storage can be reused
+        size_t                              value_count;
+    };
+
+    /**
+     * @brief   a cache-efficient double-ended priority queue for huge queues, in the
+     *          style of Sanders' sequence heaps
+     * @details Inserts go to a small min-max heap (the insertion buffer, sized to
+     *          stay in L1).  When it fills, it is sorted (`sort_heap()`) into a run and
+     *          handed to the first of a series of groups; once a group holds
+     *          `group_size` runs they are merged into one run in the next group, so a
+     *          value is moved O(log n / log group_size) times, always by sequential
+     *          merging rather than by scattered sifts.
+     *
+     *          Removals are served from two sorted deletion buffers that hold the
+     *          smallest and the largest values outside the insertion buffer.  An
+     *          empty deletion buffer is refilled with the next `buffer_size` values
+     *          from whichever end of the runs it serves, through a small min-max heap
+     *          of the runs' ends; the answer to `pop_min()` / `pop_max()` is the
+     *          better of the deletion buffer and the insertion buffer.  Whenever the
+     *          insertion buffer is flushed, it is merged with both deletion buffers
+     *          so that they still hold the extreme values.
+     *
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      CopyAssignable, and DefaultConstructible
+     */
+    template <typename DataType>
+    class sequence_heap{
+    public:
+        /**
+         * @param buffer_size  capacity of the insertion buffer and of each deletion
+         *                     buffer refill (0 picks about 16 KiB of values)
+         * @param group_size   number of runs a group collects before they are merged
+         *                     into the next group (at least 2)
+         */
+        explicit sequence_heap(size_t buffer_size = 0, size_t group_size = 16)
+            : buffer_size{std::max<size_t>(2, buffer_size ? buffer_size : (16 * 1024) / sizeof(DataType))},
+              group_size{std::max<size_t>(2, group_size)},
+              insertion(this->buffer_size), insertion_count{0}, low_first{0}, high_first{0}, value_count{0} {}
+
+        void insert(const DataType& value){
+            if(insertion_count == buffer_size){
+                flush();
+            }
+            heap_insert(value, insertion.data(), insertion_count, buffer_size);
+            ++value_count;
+        }
+
+        /**
+         * @return the minimum value
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType min(){
+            if(value_count == 0){
+                throw std::runtime_error("Cannot get min value in empty heap.");
+            }
+            return from_insertion(false) ? heap_min(insertion.data(), insertion_count) : *stored_min();
+        }
+
+        /**
+         * @return the maximum value
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType max(){
+            if(value_count == 0){
+                throw std::runtime_error("Cannot get max value in empty heap.");
+            }
+            return from_insertion(true) ? heap_max(insertion.data(), insertion_count) : *stored_max();
+        }
+
+        /**
+         * remove and return the minimum value
+         *
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType pop_min(){
+            if(value_count == 0){
+                throw std::runtime_error("Cannot remove from empty heap.");
+            }
+            --value_count;
+            if(from_insertion(false)){
+                return heap_remove_min(insertion.data(), insertion_count);
+            }
+            auto value = *stored_min();
+            if(low_first < low.size()){
+                ++low_first;
+            }
+            else{
+                ++high_first;                                                           // runs and low buffer are empty: the high buffer holds the rest
+            }
+            return value;
+        }
+
+        /**
+         * remove and return the maximum value
+         *
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType pop_max(){
+            if(value_count == 0){
+                throw std::runtime_error("Cannot remove from empty heap.");
+            }
+            --value_count;
+            if(from_insertion(true)){
+                return heap_remove_max(insertion.data(), insertion_count);
+            }
+            auto value = *stored_max();
+            if(high_first < high.size()){
+                high.pop_back();
+            }
+            else{
+                low.pop_back();                                                         // runs and high buffer are empty: the low buffer holds the rest
+            }
+            return value;
+        }
+
+        size_t size()  const { return value_count;      }
+        bool   empty() const { return value_count == 0; }
+
+    private:
+        struct run{                                                                     // a sorted run, consumed from both ends
+            std::vector<DataType> values;
+            size_t                first;
+            size_t                last;
+        };
+
+        struct run_end{                                                                 // an entry in the refill heap
+            DataType value;
+            size_t   group;
+            size_t   index;
+            friend bool operator<(const run_end& a, const run_end& b){ return a.value < b.value; }
+        };
+
+        bool from_insertion(bool largest){                                              // `true` if the answer is in the insertion buffer
+            if(insertion_count == 0){
+                return false;
+            }
+            auto stored = largest ? stored_max() : stored_min();
+            if(stored == nullptr){
+                return true;
+            }
+            return largest ? *stored < heap_max(insertion.data(), insertion_count)
+                           : heap_min(insertion.data(), insertion_count) < *stored;
+        }
+
+        const DataType* stored_min(){                                                   // smallest value outside the insertion buffer (or null)
+            if(low_first == low.size()){
+                refill(false);
+            }
+            if(low_first < low.size()){
+                return &low[low_first];
+            }
+            return high_first == high.size() ? nullptr : &high[high_first];
+        }
+
+        const DataType* stored_max(){                                                   // largest value outside the insertion buffer (or null)
+            if(high_first == high.size()){
+                refill(true);
+            }
+            if(high_first < high.size()){
+                return &high.back();
+            }
+            return low_first == low.size() ? nullptr : &low.back();
+        }
+
+        void refill(bool largest){                                                      // move the next `buffer_size` extreme values from the runs
+            std::vector<run_end> ends;
+            for(size_t g = 0; g < groups.size(); ++g){
+                for(size_t r = 0; r < groups[g].size(); ++r){
+                    auto& rn = groups[g][r];
+                    if(rn.first < rn.last){
+                        ends.push_back(run_end{largest ? rn.values[rn.last-1] : rn.values[rn.first], g, r});
+                    }
+                }
+            }
+            auto ends_count = ends.size();
+            make_heap(ends.data(), ends_count);
+            std::vector<DataType> taken;
+            while(ends_count > 0 && taken.size() < buffer_size){
+                size_t at = 0;                                                          // where the extreme end sits in the heap
+                if(largest && ends_count > 1){
+                    at = _mmheap::max_child(ends.data(), 0, ends_count-1).second;
+                }
+                auto  e  = ends[at];
+                auto& rn = groups[e.group][e.index];
+                taken.push_back(e.value);
+                if(largest){
+                    --rn.last;
+                }
+                else{
+                    ++rn.first;
+                }
+                if(rn.first < rn.last){
+                    e.value = largest ? rn.values[rn.last-1] : rn.values[rn.first];
+                    heap_replace_at_index(e, at, ends.data(), ends_count);
+                }
+                else{
+                    heap_remove_at_index(at, ends.data(), ends_count);
+                }
+            }
+            if(largest){                                                                // the buffer being refilled is empty
+                high.assign(taken.rbegin(), taken.rend());
+                high_first = 0;
+            }
+            else{
+                low.swap(taken);
+                low_first = 0;
+            }
+            drop_empty_runs();
+        }
+
+        void flush(){                                                                   // turn the full insertion buffer into a run
+            sort_heap(insertion.data(), insertion_count);
+            std::vector<DataType> merged;                                               // merge with both deletion buffers so they keep the extremes
+            merged.reserve(low.size() - low_first + insertion_count);
+            std::merge(low.begin() + low_first, low.end(), insertion.begin(), insertion.begin() + insertion_count,
+                       std::back_inserter(merged));
+            auto low_size  = low.size() - low_first;
+            auto high_size = high.size() - high_first;
+            std::vector<DataType> all;
+            all.reserve(merged.size() + high_size);
+            std::merge(merged.begin(), merged.end(), high.begin() + high_first, high.end(), std::back_inserter(all));
+            low.assign(all.begin(), all.begin() + low_size);
+            low_first = 0;
+            high.assign(all.end() - high_size, all.end());
+            high_first = 0;
+            insertion_count = 0;
+            std::vector<DataType> middle(all.begin() + low_size, all.end() - high_size);
+            if(!middle.empty()){
+                add_run(0, std::move(middle));
+            }
+        }
+
+        void add_run(size_t g, std::vector<DataType> values){
+            if(groups.size() == g){
+                groups.emplace_back();
+            }
+            auto size = values.size();
+            groups[g].push_back(run{std::move(values), 0, size});
+            if(groups[g].size() == group_size){                                         // group full: merge its runs into one run in the next group
+                std::vector<std::vector<DataType>> parts;
+                for(auto& rn : groups[g]){
+                    parts.emplace_back(rn.values.begin() + rn.first, rn.values.begin() + rn.last);
+                }
+                groups[g].clear();
+                while(parts.size() > 1){                                                // pairwise merge passes
+                    std::vector<std::vector<DataType>> next;
+                    for(size_t i = 0; i + 1 < parts.size(); i += 2){
+                        std::vector<DataType> m;
+                        m.reserve(parts[i].size() + parts[i+1].size());
+                        std::merge(parts[i].begin(), parts[i].end(), parts[i+1].begin(), parts[i+1].end(), std::back_inserter(m));
+                        next.push_back(std::move(m));
+                    }
+                    if(parts.size() % 2 == 1){
+                        next.push_back(std::move(parts.back()));
+                    }
+                    parts.swap(next);
+                }
+                if(!parts[0].empty()){
+                    add_run(g + 1, std::move(parts[0]));
+                }
+            }
+        }
+
+        void drop_empty_runs(){
+            for(auto& group : groups){
+                group.erase(std::remove_if(group.begin(), group.end(), [](const run& rn){ return rn.first == rn.last; }),
+                            group.end());
+            }
+        }
+
+        size_t                          buffer_size;
+        size_t                          group_size;
+        std::vector<DataType>           insertion;                                      // the insertion buffer (a min-max heap)
+        size_t                          insertion_count;
+        std::vector<DataType>           low;                                            // smallest stored values, ascending, from `low_first`
+        size_t                          low_first;
+        std::vector<DataType>           high;                                           // largest stored values, ascending, from `high_first`
+        size_t                          high_first;
+        std::vector<std::vector<run>>   groups;
+        size_t                          value_count;
+    };
+
+#if defined(MMHEAP_HAS_PMR)
+    namespace pmr{
+        /** a `vector_heap` whose storage comes from a `std::pmr::memory_resource` */
+        template <typename DataType>
+        using vector_heap = mmheap::vector_heap<DataType, std::pmr::polymorphic_allocator<DataType>>;
+    }
+#endif
+}
+
+#endif
@@ -0,0 +1,632 @@
+#ifndef MMHEAP_EXTERNAL_H
+#define MMHEAP_EXTERNAL_H
+/**
+ * @file mmheap_external.h
+ *
+ * Defines building blocks for external (out-of-memory) sorting on top of the
+ * Min-Max Heap functions in `mmheap.h`.
+ *
+ * @details
+ *   Runs are written as flat binary files of `DataType` records, so the record
+ *   type must be TriviallyCopyable.  I/O failures are reported by throwing
+ *   `std::runtime_error`.
+ *
+ * @license   Released under the MIT License: http://opensource.org/licenses/MIT
+ * @copyright Copyright (c) 2015 Jason L Causey, Arkansas State University
+ */
+
+#include "mmheap.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/types.h>
+#endif
+
+/**
+ * Internal helpers for external sorting.
+ */
+namespace _mmheap{
+
+    /**
+     * seek to an absolute byte offset with a 64-bit offset type, since `long`
+     * (and so `std::fseek()`) is only 32 bits on some platforms
+     *
+     * @return `false` if the seek failed or the offset does not fit the platform's offset type
+     */
+    inline bool seek_to(std::FILE* file, uint64_t offset){
+#if defined(_WIN32)
+        return offset <= static_cast<uint64_t>(std::numeric_limits<__int64>::max())
+               && _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+        return offset <= static_cast<uint64_t>(std::numeric_limits<off_t>::max())
+               && fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+    }
+
+    /**
+     * the size of an open file in bytes, found by seeking to its end
+     *
+     * @return `false` if the size could not be determined
+     */
+    inline bool file_bytes(std::FILE* file, uint64_t& bytes){
+#if defined(_WIN32)
+        if(_fseeki64(file, 0, SEEK_END) != 0){
+            return false;
+        }
+        auto end = _ftelli64(file);
+#else
+        if(fseeko(file, 0, SEEK_END) != 0){
+            return false;
+        }
+        auto end = ftello(file);
+#endif
+        if(end < 0){
+            return false;
+        }
+        bytes = static_cast<uint64_t>(end);
+        return true;
+    }
+
+    /**
+     * @brief   a buffered, append-only binary file of `DataType` records
+     *
+     * @tparam  DataType    the type of record stored - must be TriviallyCopyable
+     */
+    template <typename DataType>
+    class record_writer{
+    public:
+        record_writer(const std::string& path, size_t buffer_records = 4096)
+            : file{std::fopen(path.c_str(), "wb")}, written{0} {
+            if(!file){
+                throw std::runtime_error("Cannot open run file for writing: " + path);
+            }
+            buffer.reserve(buffer_records);
+        }
+
+        ~record_writer(){
+            if(file){
+                std::fclose(file);
+            }
+        }
+
+        record_writer(const record_writer&)            = delete;
+        record_writer& operator=(const record_writer&) = delete;
+
+        void write(const DataType& value){
+            buffer.push_back(value);
+            if(buffer.size() == buffer.capacity()){
+                flush();
+            }
+        }
+
+        void flush(){
+            if(!buffer.empty()){
+                if(std::fwrite(buffer.data(), sizeof(DataType), buffer.size(), file) != buffer.size()){
+                    throw std::runtime_error("Cannot write to run file.");
+                }
+                written += buffer.size();
+                buffer.clear();
+            }
+        }
+
+        void close(){
+            flush();
+            if(std::fclose(file) != 0){
+                file = nullptr;
+                throw std::runtime_error("Cannot close run file.");
+            }
+            file = nullptr;
+        }
+
+        size_t size() const { return written + buffer.size(); }
+
+    private:
+        std::FILE*             file;
+        size_t                 written;
+        std::vector<DataType>  buffer;
+    };
+}
+
+namespace mmheap{
+
+    /**
+     * a sorted run on disk: the records of `down` in reverse order, followed by
+     * the records of `up` in order (`down` is empty for a run kept in one file)
+     */
+    struct run_file{
+        std::string down;
+        std::string up;
+    };
+
+    /**
+     * @brief   generates sorted runs for an external merge sort by two-way
+     *          replacement selection
+     * @details Follows Martinez-Palau, Dominguez-Sal, and Larriba-Pey:
+     *              X. Martinez-Palau, D. Dominguez-Sal, and J. L. Larriba-Pey. 2010.
+     *              Two-way replacement selection. Proc. VLDB Endow. 3, 1-2, 871-881.
+     *
+     *          Classic replacement selection keeps a heap of `memory_records` values
+     *          and always emits the smallest value that is not below the last one
+     *          emitted, so a run only grows upward.  Two-way replacement selection
+     *          lets the run grow in both directions: values at or above the top of
+     *          the run are kept in a "top" min-max heap and emitted upward
+     *          (`heap_remove_min()`), values at or below the bottom of the run are
+     *          kept in a "bottom" min-max heap and emitted downward
+     *          (`heap_remove_max()`), and only values that fall between the two ends
+     *          have to wait for the next run.  On partially sorted or descending
+     *          input this produces far longer runs.
+     *
+     *          Each run is left as two files, so no record is written twice: the
+     *          downward part in descending order (`.down`) and the upward part in
+     *          ascending order (`.up`).  `kway_merger` reads the `.down` file
+     *          backward, so the pair merges as one ascending run (see `run_file`).
+     *          Passing `two_way = false` gives classic (one-way) replacement
+     *          selection for comparison, with each run in a single ascending file.
+     *
+     * @tparam  DataType    the type of record stored - must be DefaultConstructable,
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      CopyAssignable, and TriviallyCopyable
+     */
+    template <typename DataType>
+    class run_generator{
+        static_assert(std::is_trivially_copyable<DataType>::value,
+                      "run_generator requires a trivially copyable DataType");
+    public:
+        /**
+         * @param memory_records  the number of records held in memory at once
+         * @param path_prefix     run files are named `path_prefix` + run number +
+         *                        ".down" and ".up" (or ".run" for one-way runs)
+         * @param two_way         `false` for classic one-way replacement selection
+         */
+        run_generator(size_t memory_records, const std::string& path_prefix, bool two_way = true)
+            : memory{memory_records}, prefix{path_prefix}, two_way{two_way},
+              top(memory_records + 1), top_count{0}, bottom(two_way ? memory_records + 1 : 0), bottom_count{0},
+              started{false}, lo{}, hi{} {
+            if(memory == 0){
+                throw std::runtime_error("Cannot generate runs with no memory.");
+            }
+            next.reserve(memory + 1);
+        }
+
+        /** removes the files of a run left unfinished (by an exception or a missing `finish()`) */
+        ~run_generator(){
+            if(up){
+                up.reset();
+                down.reset();
+                std::remove(run_path(two_way ? ".up" : ".run").c_str());
+                std::remove(run_path(".down").c_str());
+            }
+        }
+
+        run_generator(const run_generator&)            = delete;
+        run_generator& operator=(const run_generator&) = delete;
+
+        /**
+         * add one input record
+         *
+         * @param value  the record
+         */
+        void push(const DataType& value){
+            if(!up){
+                begin_run();
+            }
+            int side = classify(value);
+            if(side > 0){
+                mmheap::heap_insert(value, top.data(), top_count, top.size());
+            }
+            else if(side < 0){
+                mmheap::heap_insert(value, bottom.data(), bottom_count, bottom.size());
+            }
+            else{
+                next.push_back(value);
+            }
+            while(top_count + bottom_count + next.size() > memory){
+                if(top_count == 0 && bottom_count == 0){                                // only next-run values left in memory
+                    end_run();
+                    begin_run();
+                }
+                else if(bottom_count == 0 || (side > 0 && top_count > 0)
+                                          || (side == 0 && top_count >= bottom_count)){
+                    emit_up();
+                }
+                else{
+                    emit_down();
+                }
+            }
+        }
+
+        /**
+         * add a sequence of input records
+         *
+         * @param values  the records
+         * @param count   the number of records in `values`
+         */
+        void push(const DataType* values, size_t count){
+            for(size_t i = 0; i < count; ++i){
+                push(values[i]);
+            }
+        }
+
+        /**
+         * write out everything still in memory and close the last run(s)
+         *
+         * @return the files of every run, in the order they were produced
+         */
+        const std::vector<run_file>& finish(){
+            while(up || !next.empty()){
+                if(!up){
+                    begin_run();
+                }
+                while(top_count > 0){
+                    emit_up();
+                }
+                while(bottom_count > 0){
+                    emit_down();
+                }
+                end_run();
+            }
+            return paths;
+        }
+
+        /** the number of records in each finished run */
+        const std::vector<size_t>& run_lengths() const { return lengths; }
+
+    private:
+        int classify(const DataType& value) const {
+            if(!started || !(value < hi)){
+                return 1;
+            }
+            if(two_way && !(lo < value)){
+                return -1;
+            }
+            return 0;
+        }
+
+        std::string run_path(const char* suffix) const {
+            return prefix + std::to_string(paths.size()) + suffix;
+        }
+
+        void begin_run(){
+            up.reset(new _mmheap::record_writer<DataType>(run_path(two_way ? ".up" : ".run")));
+            if(two_way){
+                down.reset(new _mmheap::record_writer<DataType>(run_path(".down")));
+            }
+            std::copy(next.begin(), next.end(), top.begin());                           // last run's leftovers open the new run
+            top_count = next.size();
+            mmheap::make_heap(top.data(), top_count);
+            next.clear();
+            started = false;
+        }
+
+        void end_run(){
+            size_t   length = up->size();
+            run_file files{std::string{}, run_path(two_way ? ".up" : ".run")};
+            up->close();
+            if(two_way){                                                                // the run is the reversed downward part, then the upward part
+                down->close();
+                length += down->size();
+                if(down->size() > 0){
+                    files.down = run_path(".down");
+                }
+                else{
+                    std::remove(run_path(".down").c_str());
+                }
+                down.reset();
+            }
+            up.reset();
+            paths.push_back(files);
+            lengths.push_back(length);
+        }
+
+        void emit_up(){
+            auto value = mmheap::heap_remove_min(top.data(), top_count);
+            if(!started){
+                lo = value;
+                started = true;
+            }
+            hi = value;
+            up->write(value);
+        }
+
+        void emit_down(){
+            auto value = mmheap::heap_remove_max(bottom.data(), bottom_count);
+            lo = value;
+            down->write(value);
+        }
+
+        size_t                                             memory;
+        std::string                                        prefix;
+        bool                                               two_way;
+        std::vector<DataType>                              top;
+        size_t                                             top_count;
+        std::vector<DataType>                              bottom;
+        size_t                                             bottom_count;
+        std::vector<DataType>                              next;
+        bool                                               started;
+        DataType                                           lo;
+        DataType                                           hi;
+        std::unique_ptr<_mmheap::record_writer<DataType>>  up;
+        std::unique_ptr<_mmheap::record_writer<DataType>>  down;
+        std::vector<run_file>                              paths;
+        std::vector<size_t>                                lengths;
+    };
+
+    /**
+     * @brief   merges many sorted runs into one stream, from either end
+     * @details Keeps one entry per run end in a single min-max heap: the head of
+     *          every run (for ascending output) and the tail of every run (for
+     *          descending output), so `pop_min()` and `pop_max()` can be freely
+     *          interleaved without a second structure.  Advancing a run replaces its
+     *          entry in place with `heap_replace_at_index()`, which costs one sift
+     *          instead of a removal plus an insertion.  When a run has one value left
+     *          its head and tail are the same value and share a single entry.
+     *
+     *          Runs can be arrays in memory (which must outlive the merger) or run
+     *          files such as those produced by `run_generator`, including two-way
+     *          runs whose first part is stored descending.  Run files are read
+     *          in batches of `refill_records` from whichever end is being consumed,
+     *          and are only held open while a batch is read, so thousands of runs
+     *          can be merged without running out of file handles.
+     *
+     * @tparam  DataType    the type of record stored - must be DefaultConstructable,
+     *                      LessThanComparable, Swappable, CopyConstructable, and
+     *                      CopyAssignable (and TriviallyCopyable to merge run files)
+     */
+    template <typename DataType>
+    class kway_merger{
+    public:
+        /**
+         * @param refill_records  number of records read from a run file at a time
+         */
+        explicit kway_merger(size_t refill_records = 4096)
+            : batch{std::max<size_t>(refill_records, 1)}, count{0}, remaining{0} {}
+
+        /**
+         * add a sorted run held in memory
+         *
+         * @param values  the run (ascending order)
+         * @param size    the number of values in the run
+         */
+        void add_run(const DataType* values, size_t size){
+            run r;
+            r.memory = values;
+            add(r, size);
+        }
+
+        /**
+         * add a sorted run file of `DataType` records
+         *
+         * @param path  the run file (ascending order)
+         * @throws std::runtime_error if the file cannot be read or its size is not a
+         *                            whole number of records
+         */
+        void add_run_file(const std::string& path){
+            add_run_file(run_file{std::string{}, path});
+        }
+
+        /**
+         * add a sorted run stored as a pair of files, such as a two-way run from
+         * `run_generator`
+         *
+         * @param files  the run: `files.down` (descending order, may be empty)
+         *               read backward, then `files.up` (ascending order)
+         * @throws std::runtime_error if a file cannot be read or its size is not a
+         *                            whole number of records
+         */
+        void add_run_file(const run_file& files){
+            static_assert(std::is_trivially_copyable<DataType>::value,
+                          "kway_merger run files require a trivially copyable DataType");
+            run r;
+            r.memory    = nullptr;
+            r.path      = files.up;
+            r.down_path = files.down;
+            r.down_size = files.down.empty() ? 0 : record_count(files.down);
+            auto up_size = record_count(files.up);
+            if(up_size > std::numeric_limits<size_t>::max() - r.down_size){
+                throw std::runtime_error("Cannot merge run file larger than addressable size: " + files.up);
+            }
+            add(r, r.down_size + up_size);
+        }
+
+        /** number of values not yet merged */
+        size_t size()  const { return remaining; }
+        bool   empty() const { return remaining == 0; }
+
+        /**
+         * remove and return the smallest value not yet merged
+         *
+         * @throws std::runtime_error if every run is exhausted
+         */
+        DataType pop_min(){
+            if(count == 0){
+                throw std::runtime_error("Cannot remove from empty merger.");
+            }
+            auto top = heap[0];
+            advance(0, top);
+            return top.value;
+        }
+
+        /**
+         * remove and return the largest value not yet merged
+         *
+         * @throws std::runtime_error if every run is exhausted
+         */
+        DataType pop_max(){
+            if(count == 0){
+                throw std::runtime_error("Cannot remove from empty merger.");
+            }
+            auto m   = _mmheap::max_child(heap.data(), 0, count-1);
+            auto i   = m.first ? m.second : 0;
+            auto top = heap[i];
+            advance(i, top);
+            return top.value;
+        }
+
+        /**
+         * remove up to `max_count` of the smallest values, in ascending order
+         *
+         * @return the number of values written to `out`
+         */
+        size_t pop_min(DataType* out, size_t max_count){
+            size_t n = 0;
+            while(n < max_count && count > 0){
+                out[n++] = pop_min();
+            }
+            return n;
+        }
+
+        /**
+         * remove up to `max_count` of the largest values, in descending order
+         *
+         * @return the number of values written to `out`
+         */
+        size_t pop_max(DataType* out, size_t max_count){
+            size_t n = 0;
+            while(n < max_count && count > 0){
+                out[n++] = pop_max();
+            }
+            return n;
+        }
+
+    private:
+        struct run{
+            const DataType*        memory;
+            std::string            path;                                                // file runs: the ascending part...
+            std::string            down_path;                                           // ...after this descending part, read backward
+            size_t                 down_size;
+            size_t                 lo;                                                  // unmerged values are [lo, hi)
+            size_t                 hi;
+            std::vector<DataType>  front;                                               // file runs: buffered [front_at, front_at + front.size())
+            size_t                 front_at;
+            std::vector<DataType>  back;                                                // file runs: buffered [back_at, back_at + back.size())
+            size_t                 back_at;
+        };
+
+        struct entry{
+            DataType value;
+            size_t   run_index;
+            bool     tail;
+            friend bool operator<(const entry& a, const entry& b){ return a.value < b.value; }
+        };
+
+        void add(run& r, size_t size){
+            if(size == 0){
+                return;
+            }
+            r.lo       = 0;
+            r.hi       = size;
+            r.front_at = 0;
+            r.back_at  = 0;
+            runs.push_back(std::move(r));
+            remaining += size;
+            auto index = runs.size() - 1;
+            heap.resize(count + 2);
+            mmheap::heap_insert(entry{read(runs[index], 0), index, false}, heap.data(), count, heap.size());
+            if(size > 1){
+                mmheap::heap_insert(entry{read(runs[index], size - 1), index, true}, heap.data(), count, heap.size());
+            }
+        }
+
+        /*
+         * consume the value of `current` (the entry at heap index `i`) and replace
+         * the entry with the run's next value from the same end, if there is one
+         */
+        void advance(size_t i, const entry& current){
+            auto& r = runs[current.run_index];
+            --remaining;
+            if(current.tail){
+                --r.hi;
+            }
+            else{
+                ++r.lo;
+            }
+            if(r.hi - r.lo >= 2){
+                auto position = current.tail ? r.hi - 1 : r.lo;
+                mmheap::heap_replace_at_index(entry{read(r, position), current.run_index, current.tail}, i, heap.data(), count);
+            }
+            else{                                                                       // the other end's entry already holds the last value (if any)
+                mmheap::heap_remove_at_index(i, heap.data(), count);
+            }
+        }
+
+        const DataType& read(run& r, size_t position){
+            if(r.memory){
+                return r.memory[position];
+            }
+            if(position < r.front_at || position >= r.front_at + r.front.size()){
+                if(position == r.lo){                                                   // consuming forward: read ahead
+                    r.front_at = position;
+                    load(r, r.front, position, std::min(batch, r.hi - position));
+                }
+                else{                                                                   // consuming backward: read behind
+                    if(position < r.back_at || position >= r.back_at + r.back.size()){
+                        auto first = position + 1 - std::min(batch, position + 1 - r.lo);
+                        r.back_at  = first;
+                        load(r, r.back, first, position + 1 - first);
+                    }
+                    return r.back[position - r.back_at];
+                }
+            }
+            return r.front[position - r.front_at];
+        }
+
+        void load(const run& r, std::vector<DataType>& buffer, size_t first, size_t n){
+            buffer.resize(n);
+            size_t from_down = first < r.down_size ? std::min(n, r.down_size - first) : 0;   // positions [0, down_size) are the .down file backward
+            if(from_down > 0){
+                read_records(r.down_path, buffer.data(), r.down_size - first - from_down, from_down);
+                std::reverse(buffer.begin(), buffer.begin() + from_down);
+            }
+            if(from_down < n){
+                read_records(r.path, buffer.data() + from_down, first + from_down - r.down_size, n - from_down);
+            }
+        }
+
+        static void read_records(const std::string& path, DataType* out, size_t first, size_t n){
+            std::FILE* file = std::fopen(path.c_str(), "rb");
+            if(!file
+               || !_mmheap::seek_to(file, static_cast<uint64_t>(first) * sizeof(DataType))
+               || std::fread(out, sizeof(DataType), n, file) != n){
+                if(file){
+                    std::fclose(file);
+                }
+                throw std::runtime_error("Cannot read run file: " + path);
+            }
+            std::fclose(file);
+        }
+
+        static size_t record_count(const std::string& path){
+            std::FILE* file  = std::fopen(path.c_str(), "rb");
+            uint64_t   bytes = 0;
+            if(!file || !_mmheap::file_bytes(file, bytes)){
+                if(file){
+                    std::fclose(file);
+                }
+                throw std::runtime_error("Cannot open run file for reading: " + path);
+            }
+            std::fclose(file);
+            if(bytes % sizeof(DataType) != 0){
+                throw std::runtime_error("Cannot merge run file with a partial record: " + path);
+            }
+            if(bytes / sizeof(DataType) > std::numeric_limits<size_t>::max()){
+                throw std::runtime_error("Cannot merge run file larger than addressable size: " + path);
+            }
+            return static_cast<size_t>(bytes / sizeof(DataType));
+        }
+
+        size_t              batch;
+        std::vector<run>    runs;
+        std::vector<entry>  heap;
+        size_t              count;
+        size_t              remaining;
+    };
+}
+
+#endif
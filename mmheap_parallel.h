@@ -0,0 +1,455 @@
+#ifndef MMHEAP_PARALLEL_H
+#define MMHEAP_PARALLEL_H
+/**
+ * @file mmheap_parallel.h
+ *
+ * Defines heap algorithms that spread their work across several threads.
+ *
+ * @details
+ *   The functions in `mmheap.h` are sequential.  The types and functions in this
+ *   file divide batch-oriented heap work among a fixed number of worker threads;
+ *   with a thread count of one they run entirely on the calling thread.
+ *
+ * @license   Released under the MIT License: http://opensource.org/licenses/MIT
+ * @copyright Copyright (c) 2015 Jason L Causey, Arkansas State University
+ */
+
+#include "mmheap.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Internal helpers for the parallel algorithms.
+ */
+namespace _mmheap{
+
+    /**
+     * @brief   a fixed set of worker threads that run indexed tasks together
+     * @details `run(task_count, task)` calls `task(i)` once for every `i` below
+     *          `task_count`, spread over the workers and the calling thread, and
+     *          returns when all of them have finished.
+     */
+    class worker_pool{
+    public:
+        /**
+         * @param thread_count  total threads to use, including the caller
+         */
+        explicit worker_pool(size_t thread_count)
+            : generation{0}, pending_workers{0}, stopping{false}, task_count{0}, next_task{0} {
+            for(size_t i = 1; i < thread_count; ++i){
+                workers.emplace_back([this]{ work(); });
+            }
+        }
+
+        ~worker_pool(){
+            {
+                std::lock_guard<std::mutex> lock{guard};
+                stopping = true;
+            }
+            start.notify_all();
+            for(auto& w : workers){
+                w.join();
+            }
+        }
+
+        worker_pool(const worker_pool&)            = delete;
+        worker_pool& operator=(const worker_pool&) = delete;
+
+        size_t thread_count() const { return workers.size() + 1; }
+
+        void run(size_t count, const std::function<void(size_t)>& task){
+            if(workers.empty() || count < 2){
+                for(size_t i = 0; i < count; ++i){
+                    task(i);
+                }
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock{guard};
+                current         = &task;
+                task_count      = count;
+                next_task.store(0, std::memory_order_relaxed);
+                pending_workers = workers.size();
+                ++generation;
+            }
+            start.notify_all();
+            take_tasks();
+            std::unique_lock<std::mutex> lock{guard};
+            finish.wait(lock, [this]{ return pending_workers == 0; });
+        }
+
+    private:
+        void work(){
+            size_t seen = 0;
+            while(true){
+                {
+                    std::unique_lock<std::mutex> lock{guard};
+                    start.wait(lock, [&]{ return stopping || generation != seen; });
+                    if(stopping){
+                        return;
+                    }
+                    seen = generation;
+                }
+                take_tasks();
+                std::lock_guard<std::mutex> lock{guard};
+                if(--pending_workers == 0){
+                    finish.notify_one();
+                }
+            }
+        }
+
+        void take_tasks(){
+            size_t i;
+            while((i = next_task.fetch_add(1, std::memory_order_relaxed)) < task_count){
+                (*current)(i);
+            }
+        }
+
+        std::vector<std::thread>             workers;
+        std::mutex                           guard;
+        std::condition_variable              start;
+        std::condition_variable              finish;
+        size_t                               generation;
+        size_t                               pending_workers;
+        bool                                 stopping;
+        const std::function<void(size_t)>*   current;
+        size_t                               task_count;
+        std::atomic<size_t>                  next_task;
+    };
+}
+
+namespace mmheap{
+
+    /**
+     * @brief   a parallel heap whose nodes each hold `r` sorted values
+     * @details Follows Deo and Prasad's parallel heap:
+     *              N. Deo and S. Prasad. 1992. Parallel heap: An optimal parallel
+     *              priority queue. The Journal of Supercomputing 6, 1, 87-98.
+     *
+     *          Every value in a node is no larger than every value in that node's
+     *          children, so the root holds the `r` smallest values.  A batch removal
+     *          takes the whole root, refills it from the last node, and repairs by
+     *          merging a node with its two children: the node keeps the smallest `r`
+     *          values, the child with the larger maximum takes the middle `r` (which
+     *          can't violate its subtree), and only the other child is repaired
+     *          further.  Each repair therefore moves down a single path, one level
+     *          per cycle.  Several batch removals (or several batch insertions) are
+     *          pipelined two levels apart, so all of the in-flight repairs in a cycle
+     *          touch disjoint nodes and are run in parallel by the worker threads.
+     *
+     *          Fewer than `r` values that don't yet fill a node wait in a small sorted
+     *          buffer, which removals take into account.  The maximum is tracked as
+     *          values are inserted: only the smallest values are ever removed, so it
+     *          can only change when the heap empties.
+     *
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      DefaultConstructable, LessThanComparable,
+     *                      CopyConstructable, and CopyAssignable
+     */
+    template <typename DataType>
+    class parallel_heap{
+    public:
+        /**
+         * @param node_size     `r`, the number of values stored per node (and removed
+         *                      per batch)
+         * @param thread_count  number of threads that process the pipelined repairs
+         *                      (including the calling thread)
+         */
+        explicit parallel_heap(size_t node_size, size_t thread_count = 1)
+            : r{node_size}, node_count{0}, value_count{0}, pool{thread_count} {
+            if(r == 0){
+                throw std::runtime_error("Cannot create parallel heap with empty nodes.");
+            }
+        }
+
+        /**
+         * insert several values; every full node's worth is inserted as one pipelined batch
+         *
+         * @param values       the new values to insert
+         * @param count        the number of values in `values`
+         */
+        void insert(const DataType* values, size_t count){
+            if(count == 0){
+                return;
+            }
+            auto largest = *std::max_element(values, values + count);
+            max_value    = value_count == 0 || max_value < largest ? largest : max_value;
+            value_count += count;
+            std::vector<DataType> incoming(values, values + count);
+            std::sort(incoming.begin(), incoming.end());
+            std::vector<DataType> merged(pending.size() + count);
+            std::merge(pending.begin(), pending.end(), incoming.begin(), incoming.end(), merged.begin());
+            pending.swap(merged);
+
+            size_t blocks = pending.size() / r;
+            size_t start  = pending.size() - blocks * r;                                // keep the smallest leftovers buffered
+            nodes.resize((node_count + blocks) * r);
+            size_t started = 0;
+            run_pipeline([&]() -> bool {
+                if(started == blocks){
+                    return false;
+                }
+                process p;
+                p.inserting = true;
+                p.target    = node_count++;
+                p.current   = 0;
+                p.carry.assign(pending.begin() + start + started * r, pending.begin() + start + (started + 1) * r);
+                active.push_back(std::move(p));
+                ++started;
+                return true;
+            });
+            pending.resize(start);
+        }
+
+        /**
+         * insert a single value (buffered until a node's worth is available)
+         *
+         * @param value  the new value to insert
+         */
+        void insert(const DataType& value){
+            insert(&value, 1);
+        }
+
+        /**
+         * remove the smallest `batch_count` * `r` values (pipelined)
+         *
+         * @param[out] out          array to receive the values in ascending order
+         *                          (room for `batch_count` * `node_size()`)
+         * @param      batch_count  the number of batches of `r` values to remove
+         * @return the number of values written (fewer if the heap runs out)
+         */
+        size_t remove_min_batch(DataType* out, size_t batch_count = 1){
+            size_t written = 0;
+            size_t started = 0;
+            run_pipeline([&]() -> bool {
+                if(started == batch_count || value_count == 0){
+                    return false;
+                }
+                written += take_root(out + written);
+                ++started;
+                return true;
+            });
+            return written;
+        }
+
+        DataType min() const {
+            if(value_count == 0){
+                throw std::runtime_error("Cannot get min value in empty heap.");
+            }
+            if(node_count == 0 || (!pending.empty() && pending.front() < nodes[0])){
+                return pending.front();
+            }
+            return nodes[0];
+        }
+
+        DataType max() const {
+            if(value_count == 0){
+                throw std::runtime_error("Cannot get max value in empty heap.");
+            }
+            return max_value;
+        }
+
+        size_t size()      const { return value_count; }
+        size_t node_size() const { return r; }
+
+    private:
+        struct process{
+            bool                   inserting;
+            size_t                 current;
+            size_t                 target;
+            std::vector<DataType>  carry;
+            std::vector<DataType>  scratch;
+        };
+
+        DataType* node(size_t i){ return nodes.data() + i * r; }
+
+        /*
+         * run cycles until `start_next` declines to start another process and every
+         * in-flight process has finished; a new process may start every other cycle
+         */
+        template <typename StartNext>
+        void run_pipeline(StartNext start_next){
+            bool starting = true;
+            for(size_t cycle = 0; starting || !active.empty(); ++cycle){
+                if(starting && cycle % 2 == 0){
+                    starting = start_next();
+                }
+                pool.run(active.size(), [this](size_t i){ step(active[i]); });
+                active.erase(std::remove_if(active.begin(), active.end(),
+                                            [](const process& p){ return p.current == no_node; }),
+                             active.end());
+            }
+        }
+
+        /*
+         * take the `r` smallest values (from the root and the buffer), refill the root
+         * from the last node, and start the root's repair process
+         */
+        size_t take_root(DataType* out){
+            size_t taken = 0;
+            if(node_count == 0){
+                taken = std::min(r, pending.size());
+                std::copy(pending.begin(), pending.begin() + taken, out);
+                pending.erase(pending.begin(), pending.begin() + taken);
+            }
+            else{
+                auto root = node(0);
+                std::vector<DataType> merged(r + pending.size());
+                std::merge(root, root + r, pending.begin(), pending.end(), merged.begin());
+                std::copy(merged.begin(), merged.begin() + r, out);
+                pending.assign(merged.begin() + r, merged.end());                       // root values that weren't taken replace the buffered ones that were
+                taken = r;
+                --node_count;
+                if(node_count > 0){
+                    std::copy(node(node_count), node(node_count) + r, root);
+                    for(auto& p : active){                                              // a repair sitting on the moved node restarts at the root
+                        if(p.current == node_count){
+                            p.current = no_node;
+                        }
+                    }
+                    process p;
+                    p.inserting = false;
+                    p.current   = 0;
+                    p.target    = no_node;
+                    active.push_back(std::move(p));
+                }
+                nodes.resize(node_count * r);
+            }
+            value_count -= taken;
+            return taken;
+        }
+
+        void step(process& p){
+            if(p.current == no_node){
+                return;
+            }
+            if(p.inserting){
+                step_insert(p);
+            }
+            else{
+                step_remove(p);
+            }
+        }
+
+        void step_insert(process& p){
+            if(p.current == p.target){
+                std::copy(p.carry.begin(), p.carry.end(), node(p.current));
+                p.current = no_node;
+                return;
+            }
+            auto x = node(p.current);
+            if(p.carry.front() < x[r - 1]){                                             // node keeps the smallest r, carries on with the rest
+                p.scratch.resize(2 * r);
+                std::merge(x, x + r, p.carry.begin(), p.carry.end(), p.scratch.begin());
+                std::copy(p.scratch.begin(), p.scratch.begin() + r, x);
+                std::copy(p.scratch.begin() + r, p.scratch.end(), p.carry.begin());
+            }
+            auto next = p.target;                                                       // next node on the path toward the target
+            while(_mmheap::parent(next) != p.current){
+                next = _mmheap::parent(next);
+            }
+            p.current = next;
+        }
+
+        void step_remove(process& p){
+            auto i = p.current;
+            auto l = _mmheap::left(i);
+            auto g = _mmheap::right(i);
+            auto x = node(i);
+            p.current = no_node;
+            if(l >= node_count){
+                return;
+            }
+            if(g >= node_count){                                                        // single child: it takes the largest r
+                auto c = node(l);
+                if(c[0] < x[r - 1]){
+                    p.scratch.resize(2 * r);
+                    std::merge(x, x + r, c, c + r, p.scratch.begin());
+                    std::copy(p.scratch.begin(), p.scratch.begin() + r, x);
+                    std::copy(p.scratch.begin() + r, p.scratch.end(), c);
+                    p.current = l;
+                }
+                return;
+            }
+            auto a = node(l);
+            auto b = node(g);
+            if(!(a[0] < x[r - 1]) && !(b[0] < x[r - 1])){
+                return;
+            }
+            if(a[r - 1] < b[r - 1]){                                                    // `a` is the child with the larger maximum
+                std::swap(a, b);
+                std::swap(l, g);
+            }
+            p.carry.resize(2 * r);
+            p.scratch.resize(3 * r);
+            std::merge(a, a + r, b, b + r, p.carry.begin());
+            std::merge(x, x + r, p.carry.begin(), p.carry.end(), p.scratch.begin());
+            std::copy(p.scratch.begin(),         p.scratch.begin() + r,     x);         // smallest r stay here
+            std::copy(p.scratch.begin() + r,     p.scratch.begin() + 2 * r, a);         // middle r can't violate `a`'s subtree
+            std::copy(p.scratch.begin() + 2 * r, p.scratch.end(),           b);         // largest r may: keep repairing there
+            p.current = g;
+        }
+
+        static const size_t no_node = static_cast<size_t>(-1);
+
+        size_t                   r;
+        size_t                   node_count;
+        size_t                   value_count;
+        std::vector<DataType>    nodes;
+        std::vector<DataType>    pending;
+        DataType                 max_value;
+        std::vector<process>     active;
+        _mmheap::worker_pool     pool;
+    };
+
+    /**
+     * @brief   sort any array into ascending order using several threads
+     * @details This is a generic parallel sort, not a heap algorithm: heap order
+     *          does not divide an array into independently sortable parts (every
+     *          subtree is spread across all of the lower levels), so it is not
+     *          used at all.  The work is partitioned by position instead: each
+     *          thread sorts one contiguous chunk, and the sorted chunks are then
+     *          merged pairwise, with the merges of each round also running in
+     *          parallel.  With a single thread this is just `std::sort()`.  It is a
+     *          faster way to turn a heap into a sorted array than `sort_heap()`,
+     *          which exists for sorting in place with no extra memory.
+     *
+     * @param array         the values (will be sorted)
+     * @param count         the number of values in `array`
+     * @param thread_count  number of threads to use (including the calling thread)
+     * @tparam  DataType    the type of data stored in the array - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      and CopyAssignable
+     */
+    template <typename DataType>
+    void sort_parallel(DataType* array, size_t count, size_t thread_count){
+        if(thread_count < 2 || count < 2 * thread_count){
+            std::sort(array, array + count);
+            return;
+        }
+        _mmheap::worker_pool  pool{thread_count};
+        std::vector<size_t>   bounds(thread_count + 1);
+        for(size_t i = 0; i <= thread_count; ++i){
+            bounds[i] = count / thread_count * i + std::min(i, count % thread_count);
+        }
+        pool.run(thread_count, [&](size_t i){
+            std::sort(array + bounds[i], array + bounds[i+1]);
+        });
+        for(size_t width = 1; width < thread_count; width *= 2){
+            size_t merges = (thread_count + 2 * width - 1) / (2 * width);
+            pool.run(merges, [&](size_t j){
+                auto first  = bounds[2 * width * j];
+                auto middle = bounds[std::min(2 * width * j + width,     thread_count)];
+                auto last   = bounds[std::min(2 * width * j + 2 * width, thread_count)];
+                std::inplace_merge(array + first, array + middle, array + last);
+            });
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef MMHEAP_STORAGE_H
+#define MMHEAP_STORAGE_H
+/**
+ * @file mmheap_storage.h
+ *
+ * Defines alternative storage for a Min-Max Heap (see `mmheap.h`).
+ *
+ * @details
+ *   The internal `_mmheap` primitives address the heap only through
+ *   `heap_array[i]`, so besides a plain pointer they accept any cheaply copied
+ *   accessor whose `operator[](size_t)` returns a reference to the value at an
+ *   implicit heap index.  The types in this file provide such storage for cases
+ *   where a single contiguous array is a poor fit.
+ *
+ * @license   Released under the MIT License: http://opensource.org/licenses/MIT
+ * @copyright Copyright (c) 2015 Jason L Causey, Arkansas State University
+ */
+
+#include "mmheap.h"
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace mmheap{
+
+    /**
+     * @brief   an array stored in fixed-size pages, which never relocates on growth
+     * @details Growing a contiguous array means allocating a larger one and copying
+     *          every value across - for a very large heap, a single multi-gigabyte
+     *          copy that stalls the caller.  A `segmented_array` instead grows by
+     *          appending one page at a time; values never move, so growth costs one
+     *          page allocation however large the array is.  Index `i` lives in page
+     *          `i >> page_bits` at offset `i & (page_size - 1)`, so the same implicit
+     *          heap indices work unchanged.
+     *
+     *          `access()` returns a small accessor that the `_mmheap` primitives can
+     *          use in place of a pointer.  It remains valid until the next `grow()`.
+     *
+     * @tparam  DataType    the type of data stored - must be DefaultConstructible
+     */
+    template <typename DataType>
+    class segmented_array{
+    public:
+        /** index→reference view of the pages, usable as a `_mmheap` heap array */
+        class accessor{
+        public:
+            accessor(DataType* const* pages, unsigned page_bits)
+                : pages{pages}, page_bits{page_bits}, offset_mask{(size_t(1) << page_bits) - 1} {}
+            DataType& operator[](size_t i) const { return pages[i >> page_bits][i & offset_mask]; }
+        private:
+            DataType* const*  pages;
+            unsigned          page_bits;
+            size_t            offset_mask;
+        };
+
+        /**
+         * @param page_bits  log-base-2 of the number of values per page
+         */
+        explicit segmented_array(unsigned page_bits = 16) : page_bits{page_bits} {}
+
+        /** append one page of (default-constructed) values */
+        void grow(){
+            storage.emplace_back(new DataType[page_size()]);
+            pages.push_back(storage.back().get());
+        }
+
+        /** release pages beyond those needed to hold `count` values */
+        void shrink_to(size_t count){
+            auto needed = (count + page_size() - 1) >> page_bits;
+            while(pages.size() > needed){
+                pages.pop_back();
+                storage.pop_back();
+            }
+        }
+
+        size_t   capacity()  const { return pages.size() << page_bits; }
+        size_t   page_size() const { return size_t(1) << page_bits;    }
+        accessor access()    const { return accessor{pages.data(), page_bits}; }
+
+        DataType&       operator[](size_t i)       { return pages[i >> page_bits][i & (page_size() - 1)]; }
+        const DataType& operator[](size_t i) const { return pages[i >> page_bits][i & (page_size() - 1)]; }
+
+    private:
+        unsigned                                  page_bits;
+        std::vector<std::unique_ptr<DataType[]>>  storage;
+        std::vector<DataType*>                    pages;                                // raw page pointers for `accessor`
+    };
+
+    /**
+     * @brief   a growable min-max heap on `segmented_array` storage
+     * @details Grows one page at a time with no relocation, so there is no latency
+     *          spike when capacity runs out, however large the heap is.  The
+     *          operations are the `_mmheap` primitives, run through the segmented
+     *          accessor.
+     *
+     * @tparam  DataType    the type of data stored in the heap - must be
+     *                      LessThanComparable, Swappable, CopyConstructable,
+     *                      CopyAssignable, and DefaultConstructible
+     */
+    template <typename DataType>
+    class segmented_heap{
+    public:
+        /**
+         * @param page_bits  log-base-2 of the number of values per page
+         */
+        explicit segmented_heap(unsigned page_bits = 16) : storage{page_bits}, count{0} {}
+
+        void insert(const DataType& value){
+            if(count == storage.capacity()){
+                storage.grow();
+            }
+            auto heap = storage.access();
+            heap[count] = value;
+            _mmheap::bubble_up(heap, count);
+            ++count;
+        }
+
+        /**
+         * @return the minimum value in the heap
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType min() const {
+            if(count == 0){
+                throw std::runtime_error("Cannot get min value in empty heap.");
+            }
+            return storage[0];
+        }
+
+        /**
+         * @return the maximum value in the heap
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType max() const {
+            if(count == 0){
+                throw std::runtime_error("Cannot get max value in empty heap.");
+            }
+            return storage[max_index()];
+        }
+
+        /**
+         * remove and return the minimum value in the heap
+         *
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType remove_min(){
+            if(count == 0){
+                throw std::runtime_error("Cannot remove from empty heap.");
+            }
+            return remove_at(0);
+        }
+
+        /**
+         * remove and return the maximum value in the heap
+         *
+         * @throws std::runtime_error if the heap is empty
+         */
+        DataType remove_max(){
+            if(count == 0){
+                throw std::runtime_error("Cannot remove from empty heap.");
+            }
+            return remove_at(max_index());
+        }
+
+        /** release storage pages no longer needed by the current values */
+        void shrink_to_fit(){ storage.shrink_to(count); }
+
+        size_t size()     const { return count;              }
+        bool   empty()    const { return count == 0;         }
+        size_t capacity() const { return storage.capacity(); }
+
+    private:
+        size_t max_index() const {
+            auto m = _mmheap::max_child(storage.access(), 0, count-1);
+            return m.first ? m.second : 0;
+        }
+
+        DataType remove_at(size_t index){
+            auto heap  = storage.access();
+            auto value = heap[index];
+            --count;
+            if(index < count){
+                heap[index] = heap[count];
+                _mmheap::repair_at(heap, index, value, count-1);
+            }
+            return value;
+        }
+
+        segmented_array<DataType>  storage;
+        size_t                     count;
+    };
+
+    /**
+     * @brief   contiguous storage for many small heaps of one fixed capacity
+     * @details Giving each of millions of tiny heaps its own `new[]` array costs an
+     *          allocation header, a pointer, and allocator rounding per heap, and
+     *          scatters the heaps across the address space.  A `heap_slab` stores
+     *          heap `k` at `k * capacity` in one array, with all of the counts in a
+     *          second array, so the per-heap overhead is just its count.
+     *
+     *          `operator[]` returns a `slot` whose members are the arguments every
+     *          `mmheap` function expects:
+     *
+     *              auto s = slab[k];
+     *              mmheap::heap_insert_circular(value, s.heap_array, s.count, s.max_size);
+     *
+     *          A `slot` remains valid until the next `add_heap()`.
+     *
+     * @tparam  DataType    the type of data stored - must be DefaultConstructible
+     */
+    template <typename DataType>
+    class heap_slab{
+    public:
+        /** the storage of one heap in the slab */
+        struct slot{
+            DataType* heap_array;
+            size_t&   count;
+            size_t    max_size;
+        };
+
+        /**
+         * @param heap_count  number of (initially empty) heaps
+         * @param capacity    maximum number of values in each heap
+         * @throws std::range_error if `capacity` is zero
+         */
+        heap_slab(size_t heap_count, size_t capacity) : cap{capacity} {
+            if(capacity == 0){
+                throw std::range_error("Cannot create a heap slab with zero capacity.");
+            }
+            values.resize(heap_count * cap);
+            counts.resize(heap_count, 0);
+        }
+
+        /** append a new empty heap; returns its index */
+        size_t add_heap(){
+            values.resize(values.size() + cap);
+            counts.push_back(0);
+            return counts.size() - 1;
+        }
+
+        slot operator[](size_t k){ return slot{values.data() + k * cap, counts[k], cap}; }
+
+        const DataType* heap_array(size_t k) const { return values.data() + k * cap; }
+        size_t          count(size_t k)      const { return counts[k];               }
+        size_t          heap_count()         const { return counts.size();           }
+        size_t          capacity()           const { return cap;                     }
+
+    private:
+        size_t                 cap;
+        std::vector<DataType>  values;
+        std::vector<size_t>    counts;
+    };
+}
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * @file blocking_heap_wake_test.cpp
+ *
+ * Regression test for `mmheap::blocking_heap`: a push must never re-notify an end
+ * whose waiters have all been woken already while the other end has a waiter
+ * that is still asleep.
+ *
+ * One consumer waits on the min end and two on the max end; three quick
+ * `try_push()` calls must let all three consumers finish.  Before the fix, the
+ * third push often re-notified the (already woken) min-end consumer, and the
+ * second max-end consumer slept with a value in the queue.
+ *
+ * Build and run from the repository root:
+ *     g++ -std=c++11 -O2 -pthread -I. tests/blocking_heap_wake_test.cpp -o blocking_heap_wake_test
+ *     ./blocking_heap_wake_test
+ */
+
+#include "mmheap_concurrent.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace{
+    /** run one trial; returns `false` if a consumer was left blocked */
+    bool three_push_trial(){
+        int storage[8];
+        mmheap::blocking_heap<int> heap{storage, 8};
+        std::atomic<int> done{0};
+        auto consume = [&](bool from_max){
+            int value;
+            if(from_max){
+                heap.wait_pop_max(value);
+            }
+            else{
+                heap.wait_pop_min(value);
+            }
+            ++done;
+        };
+        std::thread w1{consume, false};
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));                    // W1 waits first, so push 1 wakes it
+        std::thread m1{consume, true};
+        std::thread m2{consume, true};
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));                   // let all three block
+        for(int v = 1; v <= 3; ++v){
+            heap.try_push(v);
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+        while(done < 3 && std::chrono::steady_clock::now() < deadline){
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        bool ok = done == 3;
+        heap.close();                                                                   // release any stuck consumer
+        w1.join();
+        m1.join();
+        m2.join();
+        return ok;
+    }
+}
+
+int main(){
+    const int trials = 200;
+    int failures = 0;
+    for(int t = 0; t < trials; ++t){
+        if(!three_push_trial()){
+            ++failures;
+        }
+    }
+    std::printf("blocking_heap three-push wake-up: %d of %d trials left a consumer blocked\n", failures, trials);
+    return failures == 0 ? 0 : 1;
+}